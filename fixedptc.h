@@ -20,14 +20,21 @@
 #endif
 
 /*
- * fixedptc.h is a 32-bit or 64-bit fixed point numeric library.
+ * fixedptc.h is a 16-bit, 32-bit or 64-bit fixed point numeric library.
  *
  * The symbol FIXEDPT_BITS, if defined before this library header file
  * is included, determines the number of bits in the data type (its "width").
  * The default width is 32-bit (FIXEDPT_BITS=32) and it can be used
  * on any recent C99 compiler. The 64-bit precision (FIXEDPT_BITS=64) is
  * available on compilers which implement 128-bit "long long" types. This
- * precision has been tested on GCC 4.2+.
+ * precision has been tested on GCC 4.2+. The 16-bit width (FIXEDPT_BITS=16)
+ * halves the memory traffic of arrays whose data fits in it, such as Q8.8
+ * (the default) or Q1.15 sensor samples. Results that do not fit the format,
+ * such as exp(1) or acos(-1) in Q1.15, saturate. Where FIXEDPT_WBITS is
+ * below 6 the transcendental functions evaluate in a type of twice the
+ * width, so that their guard bits do not come out of the whole part;
+ * 32-bit builds need __int128 for that, and FIXEDPT_WBITS = 1 is refused
+ * without it and in 64-bit builds.
  *
  * The FIXEDPT_WBITS symbols governs how many bits are dedicated to the
  * "whole" part of the number (to the left of the decimal point). The larger
@@ -39,13 +46,17 @@
  * Since the number of bits in both cases is relatively low, many complex
  * functions (more complex than div & mul) take a large hit on the precision
  * of the end result because errors in precision accumulate.
+ * fixedpt_fma() and friends (and, from C++, expressions started with
+ * fixedpt_ex()) round a sum of products once instead of per product.
  * This loss of precision can be lessened by increasing the number of
  * bits dedicated to the fraction part, but at the loss of range.
  *
  * Adventurous users might utilize this library to build two data types:
  * one which has the range, and one which has the precision, and carefully
  * convert between them (including adding two number of each type to produce
- * a simulated type with a larger range and precision).
+ * a simulated type with a larger range and precision). The fixedpt_dw
+ * double-word type does this for the common case of exact products and
+ * long accumulations.
  *
  * The ideas and algorithms have been cherry-picked from a large number
  * of previous implementations available on the Internet.
@@ -87,13 +98,16 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
 
 #ifndef FIXEDPT_BITS
 #define FIXEDPT_BITS	32
 #endif
 
 #ifndef FIXEDPT_WBITS
-#if FIXEDPT_BITS == 32
+#if FIXEDPT_BITS == 16
+#define FIXEDPT_WBITS	8
+#elif FIXEDPT_BITS == 32
 #define FIXEDPT_WBITS	14
 #else
 #define FIXEDPT_WBITS	32
@@ -104,7 +118,12 @@
 #error "FIXEDPT_WBITS must be less than or equal to FIXEDPT_BITS"
 #endif
 
-#if FIXEDPT_BITS == 32
+#if FIXEDPT_BITS == 16
+typedef int16_t fixedpt;
+typedef	int32_t	fixedptd;
+typedef	uint16_t fixedptu;
+typedef	uint32_t fixedptud;
+#elif FIXEDPT_BITS == 32
 typedef int32_t fixedpt;
 typedef	int64_t	fixedptd;
 typedef	uint32_t fixedptu;
@@ -115,16 +134,212 @@ typedef	__int128_t fixedptd;
 typedef	uint64_t fixedptu;
 typedef	__uint128_t fixedptud;
 #else
-#error "FIXEDPT_BITS must be equal to 32 or 64"
+#error "FIXEDPT_BITS must be equal to 16, 32 or 64"
 #endif
 
+/*
+ * Accumulator of the reductions, see fixedpt_stats: fixedptd, except in
+ * 16-bit builds, where a 32-bit sum of squares would overflow after a few
+ * hundred elements.
+ */
+#if FIXEDPT_BITS == 16
+typedef int64_t fixedpt_acc;
+#else
+typedef fixedptd fixedpt_acc;
+#endif
+
+/*
+ * Internal type of the polynomial core, see _FIXEDPT_PBITS, and of its
+ * products: fixedpt, unless that leaves fewer than 4 guard bits and a
+ * type of four times FIXEDPT_BITS exists for the products, as in 16-bit
+ * builds and 32-bit builds with __int128. Q1.63 has neither.
+ */
+#if FIXEDPT_WBITS < 6 && (FIXEDPT_BITS == 16 || (FIXEDPT_BITS == 32 && defined(__SIZEOF_INT128__)))
+#define _FIXEDPT_WIDE_CORE
+typedef fixedptd _fixedpt_p;
+typedef fixedptud _fixedpt_pu;
+#if FIXEDPT_BITS == 16
+typedef int64_t _fixedpt_pd;
+typedef uint64_t _fixedpt_pud;
+#else
+typedef __int128_t _fixedpt_pd;
+typedef __uint128_t _fixedpt_pud;
+#endif
+#elif FIXEDPT_WBITS >= 2
+typedef fixedpt _fixedpt_p;
+typedef fixedptu _fixedpt_pu;
+typedef fixedptd _fixedpt_pd;
+typedef fixedptud _fixedpt_pud;
+#else
+#error "FIXEDPT_WBITS = 1 needs the 16-bit width, or the 32-bit width with __int128"
+#endif
+
+
+/*
+ * Double-word fixedpt: the two's complement integer hi:lo, twice as wide
+ * as fixedpt, with 2 * FIXEDPT_FBITS fraction bits. That is the scaling of
+ * an exact fixedpt product, so products and sums of products can be
+ * accumulated in it without rounding, with FIXEDPT_WBITS extra whole bits
+ * of headroom. The operations propagate carries word by word and never
+ * divide, so they compile to add/adc and a widening multiply even where
+ * fixedptd is a generic 128-bit type.
+ */
+typedef struct {
+	fixedptu lo;
+	fixedpt hi;
+} fixedpt_dw;
+
+/*
+ * Running moments of a stream or window, see fixedpt_stats_add(): the
+ * element count, their exact sum, and the exact sum of their squares as
+ * sumsq_hi * 2^FIXEDPT_BITS + sumsq_lo, with 2 * FIXEDPT_FBITS fraction
+ * bits and 0 <= sumsq_lo < 2^FIXEDPT_BITS. Every update is integer
+ * arithmetic, so elements can be removed again without drift.
+ */
+typedef struct {
+	uint64_t n;
+	fixedpt_acc sum;
+	fixedpt_acc sumsq_hi, sumsq_lo;
+} fixedpt_stats;
+
+/*
+ * One axis of a lookup table: either a uniform grid of n breakpoints
+ * x0 + k * 2^step, with step counted in fixedpt units (so step ==
+ * FIXEDPT_FBITS is a spacing of 1.0), or n increasing breakpoints x.
+ * See fixedpt_lut_axis_uniform() and fixedpt_lut_axis_points().
+ */
+typedef struct {
+	const fixedpt *x;	/* the breakpoints, or NULL on a uniform grid */
+	size_t n;
+	fixedpt x0;
+	int step;
+	size_t hint;		/* segment of the last lookup */
+} fixedpt_lut_axis;
+
+/* The slope or reciprocal width m / 2^shift of one segment of an axis */
+typedef struct {
+	fixedpt m;
+	int shift;
+} fixedpt_lut_seg;
+
+/* A 1D table of values y at the breakpoints of an axis, see fixedpt_lut_init() */
+typedef struct {
+	fixedpt_lut_axis a;
+	const fixedpt *y;
+	fixedpt_lut_seg *slope;	/* n - 1 slopes of a non-uniform axis */
+} fixedpt_lut;
+
+/*
+ * A 2D table of values z[j * a[0].n + i] at (x_i, y_j), interpolated
+ * bilinearly, see fixedpt_lut2_init().
+ */
+typedef struct {
+	fixedpt_lut_axis a[2];
+	const fixedpt *z;
+	fixedpt_lut_seg *recip[2];	/* n - 1 reciprocal widths of non-uniform axes */
+} fixedpt_lut2;
+
+/* A complex number re + i * im, see fixedpt_cmul() */
+typedef struct {
+	fixedpt re, im;
+} fixedpt_complex;
+
+/*
+ * A random number generator, see fixedpt_rng_init(): FIXEDPT_RNG_LANES
+ * independent xoshiro256++ generators stepped together, so that the bulk
+ * fills vectorize across lanes. Every draw takes the next output of the
+ * block in buf, and the bulk fills continue the same sequence.
+ */
+#define FIXEDPT_RNG_LANES	8
+
+typedef struct {
+	uint64_t s[4][FIXEDPT_RNG_LANES];	/* the state words, one column per lane */
+	uint64_t buf[FIXEDPT_RNG_LANES];	/* the outputs of the last step */
+	unsigned int pos;			/* the next unread output in buf */
+} fixedpt_rng;
+
+/*
+ * A numerically controlled oscillator, see fixedpt_nco_init(): the sine
+ * and cosine of phase + k * freq for k = 0, 1, ... The phase is kept
+ * exactly, in 2^-128 turns, and FIXEDPT_NCO_LANES consecutive samples are
+ * rotated together by one complex multiply each, with guard bits.
+ */
+#define FIXEDPT_NCO_LANES	8
+
+typedef struct {
+	_fixedpt_p s[FIXEDPT_NCO_LANES];	/* the sines of the current block */
+	_fixedpt_p c[FIXEDPT_NCO_LANES];	/* and their cosines */
+	_fixedpt_p ws, wc;		/* the rotation by FIXEDPT_NCO_LANES samples */
+	uint64_t phase;			/* the phase of s[0], in 2^-64 turns */
+	uint64_t phase_lo;		/* and its next 64 bits */
+	uint64_t freq;			/* the phase step per sample */
+	uint64_t freq_lo;		/* and its next 64 bits */
+	unsigned int pos;		/* the next unread sample of the block */
+	unsigned int left;		/* the rotations until the block is recomputed */
+} fixedpt_nco;
+
+/*
+ * The calls of one function, summed over all threads, see
+ * fixedpt_trace_snapshot(). The sampled calls are binned by their cycles,
+ * in FIXEDPT_TRACE_BUCKETS buckets of a quarter octave each (see
+ * fixedpt_trace_bucket_cycles()), and by the bit length of the largest
+ * magnitude among their arguments, from 0 for all zero to FIXEDPT_BITS.
+ * A sample includes any interrupt or preemption of the thread, which
+ * p50 and p99 are robust to, but the mean cycles per bit length are not.
+ */
+#define FIXEDPT_TRACE_BUCKETS	64
+
+typedef struct {
+	uint64_t calls;				/* all calls */
+	uint64_t sampled;			/* the calls timed */
+	uint64_t p50, p99;			/* cycles, the top of their bucket */
+	uint64_t cycles[FIXEDPT_TRACE_BUCKETS];	/* sampled calls by cycles */
+	uint64_t mag[FIXEDPT_BITS + 1];		/* sampled calls by argument bit length */
+	uint64_t mag_cycles[FIXEDPT_BITS + 1];	/* and their total cycles */
+} fixedpt_trace_stats;
+
+/*
+ * Binary array files: a 64-byte header recording FIXEDPT_BITS,
+ * FIXEDPT_WBITS, the byte order and the element count, followed by the
+ * elements, starting at a 64-byte aligned offset. They need POSIX open()
+ * and mmap(), so FIXEDPT_HAVE_FILE is only defined on Unix-like systems,
+ * and never with FIXEDPT_NO_FILE.
+ */
+#if !defined(FIXEDPT_NO_FILE) && (defined(__unix__) || defined(__APPLE__))
+#define FIXEDPT_HAVE_FILE
+#endif
+
+#ifdef FIXEDPT_HAVE_FILE
+/* A read-only view of a file's elements, see fixedpt_file_map() */
+typedef struct {
+	const fixedpt *data;
+	size_t count;
+	void *map;		/* the mapping, or NULL */
+	size_t maplen;
+	fixedpt *buf;		/* the converted copy, or NULL */
+} fixedpt_file_view;
+
+/* An append-only file being written, see fixedpt_writer_open() */
+typedef struct {
+	int fd;
+	uint64_t count;
+} fixedpt_file_writer;
+#endif
 
 #define FIXEDPT_VCSID "$Id$"
 
 #define FIXEDPT_FBITS	(FIXEDPT_BITS - FIXEDPT_WBITS)
-#define FIXEDPT_FMASK	(((fixedpt)1 << FIXEDPT_FBITS) - 1)
+#define FIXEDPT_FMASK	((fixedpt)(((fixedptu)1 << FIXEDPT_FBITS) - 1))
 
-#define fixedpt_rconst(R) ((fixedpt)((R) * FIXEDPT_ONE + ((R) >= 0 ? 0.5 : -0.5)))
+/*
+ * 2^FIXEDPT_FBITS rather than FIXEDPT_ONE, which does not fit in Q1 formats.
+ * Constants beyond the range saturate, such as 1 in Q1 formats, rather than
+ * being converted out of range.
+ */
+#define _fixedpt_rscale(R) ((R) * (double)((fixedptud)1 << FIXEDPT_FBITS) + \
+	((R) >= 0 ? 0.5 : -0.5))
+#define fixedpt_rconst(R) ((fixedpt)(_fixedpt_rscale(R) >= -(double)FIXEDPT_MIN ? FIXEDPT_MAX : \
+	_fixedpt_rscale(R) <= (double)FIXEDPT_MIN - 1 ? FIXEDPT_MIN : (fixedpt)_fixedpt_rscale(R)))
 #define fixedpt_fromint(I) ((fixedptd)(I) << FIXEDPT_FBITS)
 #define fixedpt_toint(F) ((F) >> FIXEDPT_FBITS)
 #define fixedpt_add(A,B) ((A) + (B))
@@ -136,7 +351,9 @@ typedef	__uint128_t fixedptud;
 #define fixedpt_fracpart(A) ((fixedpt)(A) & FIXEDPT_FMASK)
 
 #define FIXEDPT_ONE	((fixedpt)((fixedpt)1 << FIXEDPT_FBITS))
-#define FIXEDPT_ONE_HALF (FIXEDPT_ONE >> 1)
+#define FIXEDPT_MAX	((fixedpt)(((fixedptu)1 << (FIXEDPT_BITS - 1)) - 1))
+#define FIXEDPT_MIN	(-FIXEDPT_MAX - 1)
+#define FIXEDPT_ONE_HALF ((fixedpt)((fixedpt)1 << (FIXEDPT_FBITS - 1)))
 #define FIXEDPT_TWO	(FIXEDPT_ONE + FIXEDPT_ONE)
 
 /* Trigonometry constants */
@@ -162,6 +379,121 @@ typedef	__uint128_t fixedptud;
  * Putting them only in macros will effectively make them optional. */
 #define fixedpt_tofloat(T) ((float) ((T)*((float)(1)/(float)(1L << FIXEDPT_FBITS))))
 #define fixedpt_todouble(T) ((double) ((T)*((double)(1)/(double)(1LL << FIXEDPT_FBITS))))
+#define fixedpt_dw_todouble(D) (((double)(D).hi * (double)((fixedptud)1 << FIXEDPT_BITS) + \
+	(double)(D).lo) / ((double)((fixedptud)1 << FIXEDPT_FBITS) * \
+	(double)((fixedptud)1 << FIXEDPT_FBITS)))
+
+/* Instruction set paths of the batch kernels, see fixedpt_dispatch_force() */
+#define FIXEDPT_ISA_SCALAR	0
+#define FIXEDPT_ISA_AVX2	1
+#define FIXEDPT_ISA_AVX512	2
+
+/*
+ * Elements per work item of the fixedpt_parallel_* functions: 64 KiB of
+ * input, so a chunk and its output stay in a core's L2 cache.
+ */
+#ifndef FIXEDPT_PARALLEL_CHUNK
+#define FIXEDPT_PARALLEL_CHUNK	(65536 / sizeof(fixedpt))
+#endif
+
+/* Polynomial evaluation schemes, see fixedpt_poly() */
+#define FIXEDPT_POLY_HORNER	0
+#define FIXEDPT_POLY_ESTRIN	1
+
+/* The scheme the transcendental functions are built with */
+#ifndef FIXEDPT_POLY_SCHEME
+#define FIXEDPT_POLY_SCHEME	FIXEDPT_POLY_ESTRIN
+#endif
+
+/* Rounding modes for the array conversions from float and double */
+#define FIXEDPT_ROUND_NEAREST	0
+#define FIXEDPT_ROUND_TRUNCATE	1
+
+/*
+ * Bit-packed arrays, see fixedpt_pack(): blocks of FIXEDPT_PACK_BLOCK
+ * elements, stored in width bits each, either as they are (saturated to
+ * the field), as the distance from the block minimum, or scaled down by a
+ * per-block shared exponent.
+ */
+#define FIXEDPT_PACK_BLOCK	64
+#define FIXEDPT_PACK_PLAIN	0
+#define FIXEDPT_PACK_OFFSET	1
+#define FIXEDPT_PACK_EXPONENT	2
+
+/* fixedpt_file_map() flag: convert other formats into memory */
+#define FIXEDPT_FILE_CONVERT	1
+
+/* fixedpt_file_* errors besides -1, which leaves the cause in errno */
+#define FIXEDPT_FILE_EFORMAT	-2	/* not a fixedpt file, or truncated */
+#define FIXEDPT_FILE_EQFORMAT	-3	/* other Q format or byte order */
+
+/*
+ * Error counters, see fixedpt_errors_snapshot(): built only with
+ * FIXEDPT_ERROR_COUNTERS, and indexed by the function that detected the
+ * error and its class. An error is counted where it happens, so e.g. the
+ * overflow of fixedpt_pow() shows up under FIXEDPT_FN_EXP.
+ */
+#define FIXEDPT_FN_MUL		0	/* fixedpt_mul() */
+#define FIXEDPT_FN_FMA		1	/* fixedpt_fma(), _mla() and _mls() */
+#define FIXEDPT_FN_DIV		2	/* fixedpt_div() */
+#define FIXEDPT_FN_DW		3	/* fixedpt_dw_to() */
+#define FIXEDPT_FN_SQRT		4	/* fixedpt_sqrt() */
+#define FIXEDPT_FN_EXP		5	/* fixedpt_exp() */
+#define FIXEDPT_FN_LN		6	/* fixedpt_ln() */
+#define FIXEDPT_FN_POW		7	/* fixedpt_pow() */
+#define FIXEDPT_FN_ASIN		8	/* fixedpt_asin() */
+#define FIXEDPT_FN_ACOS		9	/* fixedpt_acos() */
+#define FIXEDPT_FN_CABS		10	/* fixedpt_cabs() and _cabs2() */
+#define FIXEDPT_FN_CONVERT	11	/* fixedpt_from_float_array() and _double_array() */
+#define FIXEDPT_FN_PACK		12	/* fixedpt_pack() */
+#define FIXEDPT_FN_COUNT	13
+
+#define FIXEDPT_ERR_DOMAIN	0	/* argument outside the domain */
+#define FIXEDPT_ERR_OVERFLOW	1	/* result wrapped around */
+#define FIXEDPT_ERR_DIVZERO	2	/* division by zero */
+#define FIXEDPT_ERR_SATURATE	3	/* result clamped to the range */
+#define FIXEDPT_ERR_COUNT	4
+
+/* Threads with counters of their own; any further threads share one set */
+#ifndef FIXEDPT_ERROR_THREADS
+#define FIXEDPT_ERROR_THREADS	64
+#endif
+
+/*
+ * Functions traced with FIXEDPT_TRACE, see fixedpt_trace_snapshot(). Only
+ * the calls of the program are traced, not those the library makes
+ * itself, so e.g. fixedpt_pow() counts once, with the time it spends in
+ * fixedpt_exp() and fixedpt_ln().
+ */
+#define FIXEDPT_TRACE_MUL	0
+#define FIXEDPT_TRACE_DIV	1
+#define FIXEDPT_TRACE_FMA	2
+#define FIXEDPT_TRACE_MLA	3
+#define FIXEDPT_TRACE_MLS	4
+#define FIXEDPT_TRACE_SQRT	5
+#define FIXEDPT_TRACE_EXP	6
+#define FIXEDPT_TRACE_LN	7
+#define FIXEDPT_TRACE_LOG	8
+#define FIXEDPT_TRACE_POW	9
+#define FIXEDPT_TRACE_SIN	10
+#define FIXEDPT_TRACE_COS	11
+#define FIXEDPT_TRACE_SINCOS	12
+#define FIXEDPT_TRACE_TAN	13
+#define FIXEDPT_TRACE_ASIN	14
+#define FIXEDPT_TRACE_ACOS	15
+#define FIXEDPT_TRACE_ATAN	16
+#define FIXEDPT_TRACE_ATAN2	17
+#define FIXEDPT_TRACE_COUNT	18
+
+/* Every FIXEDPT_TRACE_PERIOD-th call of a function is timed, on average */
+#ifndef FIXEDPT_TRACE_PERIOD
+#define FIXEDPT_TRACE_PERIOD	64
+#endif
+
+/* Threads with trace counters of their own, see FIXEDPT_ERROR_THREADS */
+#ifndef FIXEDPT_TRACE_THREADS
+#define FIXEDPT_TRACE_THREADS	64
+#endif
 
 /* Function prototypes */
 
@@ -171,541 +503,4790 @@ extern "C" {
 
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_mul(fixedpt A, fixedpt B);
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_div(fixedpt A, fixedpt B);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_fma(fixedpt A, fixedpt B, fixedpt C);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_mla(fixedpt acc, fixedpt A, fixedpt B);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_mls(fixedpt acc, fixedpt A, fixedpt B);
+_FIXEDPT_PROTOTYPE fixedpt_dw fixedpt_dw_from(fixedpt A);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_dw_to(fixedpt_dw A);
+_FIXEDPT_PROTOTYPE fixedpt_dw fixedpt_dw_add(fixedpt_dw A, fixedpt_dw B);
+_FIXEDPT_PROTOTYPE fixedpt_dw fixedpt_dw_sub(fixedpt_dw A, fixedpt_dw B);
+_FIXEDPT_PROTOTYPE fixedpt_dw fixedpt_dw_mul(fixedpt A, fixedpt B);
+_FIXEDPT_PROTOTYPE fixedpt_dw fixedpt_dw_fma(fixedpt_dw acc, fixedpt A, fixedpt B);
 _FIXEDPT_PROTOTYPE void fixedpt_str(fixedpt A, char *str, int max_dec);
 _FIXEDPT_PROTOTYPE char* fixedpt_cstr(const fixedpt A, const int max_dec);
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_sqrt(fixedpt A);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_poly(fixedpt x, const fixedpt *c, int deg, int scheme);
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_exp(fixedpt x);
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_ln(fixedpt x);
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_log(fixedpt x, fixedpt base);
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_pow(fixedpt x, fixedpt exp);
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_sin(fixedpt angle);
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_cos(fixedpt angle);
+_FIXEDPT_PROTOTYPE void fixedpt_sincos(fixedpt angle, fixedpt *s, fixedpt *c);
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_tan(fixedpt angle);
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_asin(fixedpt x);
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_acos(fixedpt x);
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_atan(fixedpt x);
 _FIXEDPT_PROTOTYPE fixedpt fixedpt_atan2(fixedpt y, fixedpt x);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_sigmoid(fixedpt x);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_tanh(fixedpt x);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_gelu(fixedpt x);
+_FIXEDPT_PROTOTYPE fixedpt_complex fixedpt_cmul(fixedpt_complex a, fixedpt_complex b);
+_FIXEDPT_PROTOTYPE fixedpt_complex fixedpt_conj(fixedpt_complex a);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_cabs2(fixedpt_complex a);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_cabs(fixedpt_complex a);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_carg(fixedpt_complex a);
+_FIXEDPT_PROTOTYPE fixedpt_complex fixedpt_cexp(fixedpt_complex a);
+_FIXEDPT_PROTOTYPE void fixedpt_mul_batch(const fixedpt *a, const fixedpt *b, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_scale_batch(const fixedpt *in, fixedpt k, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_sqrt_batch(const fixedpt *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_exp_batch(const fixedpt *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_ln_batch(const fixedpt *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_sin_batch(const fixedpt *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_cos_batch(const fixedpt *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_atan_batch(const fixedpt *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_atan2_batch(const fixedpt *y, const fixedpt *x, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_sigmoid_batch(const fixedpt *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_tanh_batch(const fixedpt *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_gelu_batch(const fixedpt *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_softmax(const fixedpt *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_cmul_batch(const fixedpt_complex *a, const fixedpt_complex *b,
+    fixedpt_complex *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_cmul_split_batch(const fixedpt *are, const fixedpt *aim,
+    const fixedpt *bre, const fixedpt *bim, fixedpt *re, fixedpt *im, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_cabs_batch(const fixedpt_complex *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_cabs_split_batch(const fixedpt *re, const fixedpt *im, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_rng_init(fixedpt_rng *rng, uint64_t seed, uint64_t stream);
+_FIXEDPT_PROTOTYPE uint64_t fixedpt_rng_bits(fixedpt_rng *rng);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_rng_uniform(fixedpt_rng *rng);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_rng_range(fixedpt_rng *rng, fixedpt lo, fixedpt hi);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_rng_triangular(fixedpt_rng *rng, fixedpt amp);
+_FIXEDPT_PROTOTYPE void fixedpt_rng_uniform_fill(fixedpt_rng *rng, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_rng_range_fill(fixedpt_rng *rng, fixedpt lo, fixedpt hi, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_rng_triangular_fill(fixedpt_rng *rng, fixedpt amp, fixedpt *out, size_t n);
+#if FIXEDPT_WBITS >= 6
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_rng_normal(fixedpt_rng *rng);
+_FIXEDPT_PROTOTYPE void fixedpt_rng_normal_fill(fixedpt_rng *rng, fixedpt *out, size_t n);
+#endif
+_FIXEDPT_PROTOTYPE void fixedpt_nco_init(fixedpt_nco *nco, fixedpt freq, fixedpt phase);
+_FIXEDPT_PROTOTYPE void fixedpt_nco_set_freq(fixedpt_nco *nco, fixedpt freq);
+_FIXEDPT_PROTOTYPE void fixedpt_nco_next(fixedpt_nco *nco, fixedpt *s, fixedpt *c);
+_FIXEDPT_PROTOTYPE void fixedpt_nco_fill(fixedpt_nco *nco, fixedpt *s, fixedpt *c, size_t n);
+#ifndef FIXEDPT_NO_FLOAT
+_FIXEDPT_PROTOTYPE size_t fixedpt_from_float_array(const float *in, fixedpt *out, size_t n, int round);
+_FIXEDPT_PROTOTYPE size_t fixedpt_from_double_array(const double *in, fixedpt *out, size_t n, int round);
+_FIXEDPT_PROTOTYPE void fixedpt_to_float_array(const fixedpt *in, float *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_to_double_array(const fixedpt *in, double *out, size_t n);
+#endif
+_FIXEDPT_PROTOTYPE size_t fixedpt_pack_size(size_t n, int width, int mode);
+_FIXEDPT_PROTOTYPE size_t fixedpt_pack(const fixedpt *in, size_t n, int width, int mode, uint64_t *packed);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_unpack_at(const uint64_t *packed, size_t i, int width, int mode);
+_FIXEDPT_PROTOTYPE void fixedpt_unpack(const uint64_t *packed, size_t first, size_t n, int width, int mode, fixedpt *out);
+_FIXEDPT_PROTOTYPE void fixedpt_unpack_map(const uint64_t *packed, size_t n, int width, int mode,
+    void (*fn)(const fixedpt *, fixedpt *, size_t), fixedpt *out);
+_FIXEDPT_PROTOTYPE fixedpt_acc fixedpt_sum(const fixedpt *in, size_t n);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_mean(const fixedpt *in, size_t n);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_var(const fixedpt *in, size_t n);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_rms(const fixedpt *in, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_minmax(const fixedpt *in, size_t n, fixedpt *min, fixedpt *max);
+_FIXEDPT_PROTOTYPE size_t fixedpt_histogram(const fixedpt *in, size_t n, fixedpt lo, fixedpt hi,
+    size_t *counts, size_t nbins);
+_FIXEDPT_PROTOTYPE void fixedpt_stats_init(fixedpt_stats *s);
+_FIXEDPT_PROTOTYPE void fixedpt_stats_add(fixedpt_stats *s, const fixedpt *in, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_stats_remove(fixedpt_stats *s, const fixedpt *in, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_stats_slide(fixedpt_stats *s, fixedpt in, fixedpt out);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_stats_mean(const fixedpt_stats *s);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_stats_var(const fixedpt_stats *s);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_stats_rms(const fixedpt_stats *s);
+_FIXEDPT_PROTOTYPE int fixedpt_lut_axis_uniform(fixedpt_lut_axis *a, fixedpt x0, int step, size_t n);
+_FIXEDPT_PROTOTYPE int fixedpt_lut_axis_points(fixedpt_lut_axis *a, const fixedpt *x, size_t n);
+_FIXEDPT_PROTOTYPE int fixedpt_lut_init(fixedpt_lut *lut, const fixedpt_lut_axis *a, const fixedpt *y,
+    fixedpt_lut_seg *slope);
+_FIXEDPT_PROTOTYPE int fixedpt_lut2_init(fixedpt_lut2 *lut, const fixedpt_lut_axis *ax, const fixedpt_lut_axis *ay,
+    const fixedpt *z, fixedpt_lut_seg *xrecip, fixedpt_lut_seg *yrecip);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_lut_eval(fixedpt_lut *lut, fixedpt x);
+_FIXEDPT_PROTOTYPE void fixedpt_lut_eval_batch(fixedpt_lut *lut, const fixedpt *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_lut2_eval(fixedpt_lut2 *lut, fixedpt x, fixedpt y);
+_FIXEDPT_PROTOTYPE void fixedpt_lut2_eval_batch(fixedpt_lut2 *lut, const fixedpt *x, const fixedpt *y,
+    fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE int fixedpt_dispatch_init(void);
+_FIXEDPT_PROTOTYPE int fixedpt_dispatch_force(int isa);
+_FIXEDPT_PROTOTYPE int fixedpt_dispatch_isa(void);
+_FIXEDPT_PROTOTYPE void fixedpt_parallel_map(fixedpt (*fn)(fixedpt), const fixedpt *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE void fixedpt_parallel_map_batch(void (*fn)(const fixedpt *, fixedpt *, size_t),
+    const fixedpt *in, fixedpt *out, size_t n);
+_FIXEDPT_PROTOTYPE fixedpt_acc fixedpt_parallel_sum(const fixedpt *in, size_t n);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_parallel_min(const fixedpt *in, size_t n);
+_FIXEDPT_PROTOTYPE fixedpt fixedpt_parallel_max(const fixedpt *in, size_t n);
+#ifdef FIXEDPT_ERROR_COUNTERS
+_FIXEDPT_PROTOTYPE uint64_t fixedpt_errors_snapshot(uint64_t counts[FIXEDPT_FN_COUNT][FIXEDPT_ERR_COUNT]);
+_FIXEDPT_PROTOTYPE const char *fixedpt_errors_fn_name(int fn);
+_FIXEDPT_PROTOTYPE const char *fixedpt_errors_class_name(int cls);
+#endif
+#ifdef FIXEDPT_TRACE
+_FIXEDPT_PROTOTYPE int fixedpt_trace_snapshot(int fn, fixedpt_trace_stats *st);
+_FIXEDPT_PROTOTYPE const char *fixedpt_trace_name(int fn);
+_FIXEDPT_PROTOTYPE uint64_t fixedpt_trace_bucket_cycles(int i);
+#endif
+#ifdef FIXEDPT_HAVE_FILE
+_FIXEDPT_PROTOTYPE int fixedpt_file_map(const char *path, fixedpt_file_view *view, int flags);
+_FIXEDPT_PROTOTYPE void fixedpt_file_unmap(fixedpt_file_view *view);
+_FIXEDPT_PROTOTYPE int fixedpt_file_create(const char *path, size_t n, fixedpt_file_view *view, fixedpt **data);
+_FIXEDPT_PROTOTYPE int fixedpt_file_write(const char *path, const fixedpt *data, size_t n);
+_FIXEDPT_PROTOTYPE int fixedpt_writer_open(fixedpt_file_writer *w, const char *path);
+_FIXEDPT_PROTOTYPE int fixedpt_writer_append(fixedpt_file_writer *w, const fixedpt *data, size_t n);
+_FIXEDPT_PROTOTYPE int fixedpt_writer_close(fixedpt_file_writer *w);
+#endif
 
 
 #ifdef __cplusplus
 }
 #endif
 
-#ifdef _FIXEDPT_IMPLEMENTATION
+#ifdef __cplusplus
+/*
+ * Expression templates: wrapping one operand with fixedpt_ex() turns an
+ * expression such as
+ *
+ *	fixedpt r = fixedpt_ex(a) * b + fixedpt_ex(c) * d - e;
+ *
+ * into a single fixedptd accumulation with 2 * FBITS fraction bits,
+ * shifted and rounded to nearest once on the conversion back to fixedpt.
+ * Products of products are evaluated (and rounded) operand first, and
+ * the intermediate sums must fit in fixedptd.
+ */
+namespace fixedpt_expr {
 
-/* Implementation of the functions */
+template <class E> struct node {
+	const E &self() const { return (static_cast<const E &>(*this)); }
+	operator fixedpt() const { return (self().value()); }
+	fixedpt round() const
+	{
+		fixedptd acc = self().acc();
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+		return ((fixedpt)(((acc >> (FIXEDPT_FBITS - 1)) + 1) >> 1));
+	}
+};
 
+struct leaf : node<leaf> {
+	fixedpt v;
 
-/* Multiplies two fixedpt numbers, returns the result. */
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_mul(fixedpt A, fixedpt B)
-{
-	fixedptd product = (fixedptd)A * (fixedptd)B;
-	fixedpt result = (fixedpt)(product >> FIXEDPT_FBITS);
-	fixedpt rounding = (fixedpt)((product  >> (FIXEDPT_FBITS - 1)) & 1);
+	explicit leaf(fixedpt A) : v(A) {}
+	fixedptd acc() const { return ((fixedptd)v << FIXEDPT_FBITS); }
+	fixedpt value() const { return (v); }
+};
 
-	return (result + rounding);
-}
+struct prod : node<prod> {
+	fixedpt a, b;
 
+	prod(fixedpt A, fixedpt B) : a(A), b(B) {}
+	fixedptd acc() const { return ((fixedptd)a * (fixedptd)b); }
+	fixedpt value() const { return (this->round()); }
+};
 
-/* Divides two fixedpt numbers, returns the result. */
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_div(fixedpt A, fixedpt B)
+template <class L, class R, int SIGN> struct sum : node<sum<L, R, SIGN> > {
+	L l;
+	R r;
+
+	sum(const L &A, const R &B) : l(A), r(B) {}
+	fixedptd acc() const { return (SIGN > 0 ? l.acc() + r.acc() : l.acc() - r.acc()); }
+	fixedpt value() const { return (this->round()); }
+};
+
+template <class E> struct neg : node<neg<E> > {
+	E e;
+
+	explicit neg(const E &A) : e(A) {}
+	fixedptd acc() const { return (-e.acc()); }
+	fixedpt value() const { return (this->round()); }
+};
+
+template <class A, class B>
+inline prod operator*(const node<A> &a, const node<B> &b)
+{ return (prod(a.self().value(), b.self().value())); }
+template <class A>
+inline prod operator*(const node<A> &a, fixedpt b)
+{ return (prod(a.self().value(), b)); }
+template <class B>
+inline prod operator*(fixedpt a, const node<B> &b)
+{ return (prod(a, b.self().value())); }
+
+template <class A, class B>
+inline sum<A, B, 1> operator+(const node<A> &a, const node<B> &b)
+{ return (sum<A, B, 1>(a.self(), b.self())); }
+template <class A>
+inline sum<A, leaf, 1> operator+(const node<A> &a, fixedpt b)
+{ return (sum<A, leaf, 1>(a.self(), leaf(b))); }
+template <class B>
+inline sum<leaf, B, 1> operator+(fixedpt a, const node<B> &b)
+{ return (sum<leaf, B, 1>(leaf(a), b.self())); }
+
+template <class A, class B>
+inline sum<A, B, -1> operator-(const node<A> &a, const node<B> &b)
+{ return (sum<A, B, -1>(a.self(), b.self())); }
+template <class A>
+inline sum<A, leaf, -1> operator-(const node<A> &a, fixedpt b)
+{ return (sum<A, leaf, -1>(a.self(), leaf(b))); }
+template <class B>
+inline sum<leaf, B, -1> operator-(fixedpt a, const node<B> &b)
+{ return (sum<leaf, B, -1>(leaf(a), b.self())); }
+
+template <class A>
+inline neg<A> operator-(const node<A> &a)
+{ return (neg<A>(a.self())); }
+
+} /* namespace fixedpt_expr */
+
+/* Marks a fixedpt operand as the start of a fused expression */
+inline fixedpt_expr::leaf fixedpt_ex(fixedpt A)
 {
-	return (((fixedptd)A << FIXEDPT_FBITS) / (fixedptd)B);
+	return (fixedpt_expr::leaf(A));
 }
+#endif
 
-/*
- * Note: adding and substracting fixedpt numbers can be done by using
- * the regular integer operators + and -.
- */
+#ifdef _FIXEDPT_IMPLEMENTATION
 
-/**
- * Convert the given fixedpt number to a decimal string.
- * The max_dec argument specifies how many decimal digits to the right
- * of the decimal point to generate. If set to -1, the "default" number
- * of decimal digits will be used (2 for 32-bit fixedpt width, 10 for
- * 64-bit fixedpt width); If set to -2, "all" of the digits will
- * be returned, meaning there will be invalid, bogus digits outside the
- * specified precisions.
- */
-_FIXEDPT_FUNCTYPE void fixedpt_str(fixedpt A, char *str, int max_dec)
-{
-	int ndec = 0, slen = 0;
-	char tmp[12] = {0};
-	fixedptud fr, ip;
-	const fixedptud one = (fixedptud)1 << FIXEDPT_BITS;
-	const fixedptud mask = one - 1;
+/* Implementation of the functions */
 
-	if (max_dec == -1)
-#if FIXEDPT_BITS == 32
-#if FIXEDPT_WBITS > 16
-		max_dec = 2;
+#if defined(__GNUC__)
+#define _FIXEDPT_INLINE	static inline __attribute__((always_inline))
 #else
-		max_dec = 4;
+#define _FIXEDPT_INLINE	static inline
 #endif
-#elif FIXEDPT_BITS == 64
-		max_dec = 10;
+
+/* Full unrolling of the fixed-count loops, see _fixedpt_poly() */
+#if defined(__clang__)
+#define _FIXEDPT_UNROLL	_Pragma("unroll")
+#elif defined(__GNUC__) && __GNUC__ >= 8
+#define _FIXEDPT_UNROLL	_Pragma("GCC unroll 16")
 #else
-#error Invalid width
+#define _FIXEDPT_UNROLL
 #endif
-	else if (max_dec == -2)
-		max_dec = 15;
 
-	if (A < 0) {
-		str[slen++] = '-';
-		A *= -1;
-	}
+#if !defined(FIXEDPT_NO_DISPATCH) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define _FIXEDPT_X86_DISPATCH
+#endif
 
-	ip = fixedpt_toint(A);
-	do {
-		tmp[ndec++] = '0' + ip % 10;
-		ip /= 10;
-	} while (ip != 0);
+#ifdef FIXEDPT_HAVE_FILE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-	while (ndec > 0)
-		str[slen++] = tmp[--ndec];
-	str[slen++] = '.';
+#ifdef __cplusplus
+extern "C" {
+#endif
 
-	fr = (fixedpt_fracpart(A) << FIXEDPT_WBITS) & mask;
-	do {
-		fr = (fr & mask) * 10;
+/*
+ * Per-thread counters, for the error counters and the tracing below. Each
+ * of the first n threads to count something claims one of n + 1 sets of
+ * counters, which only it writes, so counting takes a thread-local load
+ * and an increment. Later threads share the last set, updated
+ * atomically. The readers sum the sets with relaxed loads. With
+ * _FIXEDPT_STATIC every translation unit has counters of its own.
+ */
+#if defined(FIXEDPT_ERROR_COUNTERS) || defined(FIXEDPT_TRACE)
+#ifndef __GNUC__
+#error "FIXEDPT_ERROR_COUNTERS and FIXEDPT_TRACE need the __atomic builtins of GCC or Clang"
+#endif
 
-		str[slen++] = '0' + (fr >> FIXEDPT_BITS) % 10;
-		ndec++;
-	} while (fr != 0 && ndec < max_dec);
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define _FIXEDPT_TLS	thread_local
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define _FIXEDPT_TLS	_Thread_local
+#else
+#define _FIXEDPT_TLS	__thread
+#endif
 
-	if (ndec > 1 && str[slen-1] == '0')
-		str[slen-1] = '\0'; /* cut off trailing 0 */
+/* Claims the next of n sets, or returns n, the shared one, once all are taken */
+static unsigned int _fixedpt_claim(unsigned int *used, unsigned int n)
+{
+	unsigned int i = __atomic_load_n(used, __ATOMIC_RELAXED);
+
+	while (i < n && !__atomic_compare_exchange_n(used, &i, i + 1, 1,
+	    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+	return (i < n ? i : n);
+}
+
+/* Adds n to a counter of the own set, or of the shared one */
+_FIXEDPT_INLINE void _fixedpt_count(uint64_t *c, uint64_t n, int shared)
+{
+	if (shared)
+		__atomic_fetch_add(c, n, __ATOMIC_RELAXED);
 	else
-		str[slen] = '\0';
+		__atomic_store_n(c, __atomic_load_n(c, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
 }
+#endif
 
+/*
+ * Error counters.
+ *
+ * With FIXEDPT_ERROR_COUNTERS, the scalar functions count the errors they
+ * detect, without changing their results. A division by zero is counted
+ * and then carried out, so it traps as it would without the counters
+ * (SIGFPE on x86), and a SIGFPE handler finds it counted. The batch
+ * kernels are not instrumented, except that the saturations the array
+ * conversions and fixedpt_pack() return are added up.
+ *
+ * The first FIXEDPT_ERROR_THREADS threads that report an error get
+ * counters of their own, and the count is only reached on the error
+ * path. Without FIXEDPT_ERROR_COUNTERS the checks expand to nothing.
+ */
+#ifdef FIXEDPT_ERROR_COUNTERS
+typedef uint64_t _fixedpt_errset[FIXEDPT_FN_COUNT][FIXEDPT_ERR_COUNT];
 
-/* Converts the given fixedpt number into a string, using a static
- * (non-threadsafe) string buffer */
-_FIXEDPT_FUNCTYPE char* fixedpt_cstr(const fixedpt A, const int max_dec)
+static _fixedpt_errset _fixedpt_errsets[FIXEDPT_ERROR_THREADS + 1];
+static unsigned int _fixedpt_errsets_used = 0;
+static _FIXEDPT_TLS _fixedpt_errset *_fixedpt_errset_own = NULL;
+
+/* Adds n errors of class cls to function fn */
+__attribute__((noinline, cold)) static void _fixedpt_error(int fn, int cls, uint64_t n)
 {
-	static char str[25];
+	_fixedpt_errset *set = _fixedpt_errset_own;
 
-	fixedpt_str(A, str, max_dec);
-	return (str);
+	if (set == NULL) {
+		set = &_fixedpt_errsets[_fixedpt_claim(&_fixedpt_errsets_used, FIXEDPT_ERROR_THREADS)];
+		_fixedpt_errset_own = set;
+	}
+	_fixedpt_count(&(*set)[fn][cls], n, set == &_fixedpt_errsets[FIXEDPT_ERROR_THREADS]);
 }
 
-/* Returns the square root of the given number, or -1 in case of error */
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_sqrt(fixedpt A)
+#define _FIXEDPT_CHECK(cond, fn, cls)					\
+	do {								\
+		if (__builtin_expect(!!(cond), 0))			\
+			_fixedpt_error((fn), (cls), 1);			\
+	} while (0)
+#define _FIXEDPT_CHECK_N(n, fn, cls)					\
+	do {								\
+		if (__builtin_expect((n) != 0, 0))			\
+			_fixedpt_error((fn), (cls), (uint64_t)(n));	\
+	} while (0)
+
+/*
+ * Stores the counts of all threads, including those that have exited,
+ * into counts, and returns their total. The counts only grow, so the
+ * rates are the differences between two snapshots. A snapshot only reads
+ * the counters, and may miss the errors counted while it runs.
+ */
+_FIXEDPT_FUNCTYPE uint64_t fixedpt_errors_snapshot(uint64_t counts[FIXEDPT_FN_COUNT][FIXEDPT_ERR_COUNT])
 {
-	int invert = 0;
-	int iter = FIXEDPT_FBITS;
-	fixedpt l;
-    int i;
+	uint64_t total = 0;
+	int t, fn, cls;
 
-	if (A < 0)
-		return (-1);
-	if (A == 0 || A == FIXEDPT_ONE)
-		return (A);
-	if (A < FIXEDPT_ONE && A > 6) {
-		invert = 1;
-		A = fixedpt_div(FIXEDPT_ONE, A);
-	}
-	if (A > FIXEDPT_ONE) {
-		fixedpt s = A;
-
-		iter = 0;
-		while (s > 0) {
-			s >>= 2;
-			iter++;
+	for (fn = 0; fn < FIXEDPT_FN_COUNT; fn++)
+		for (cls = 0; cls < FIXEDPT_ERR_COUNT; cls++)
+			counts[fn][cls] = 0;
+	for (t = 0; t <= FIXEDPT_ERROR_THREADS; t++) {
+		for (fn = 0; fn < FIXEDPT_FN_COUNT; fn++) {
+			for (cls = 0; cls < FIXEDPT_ERR_COUNT; cls++) {
+				uint64_t c = __atomic_load_n(&_fixedpt_errsets[t][fn][cls],
+				    __ATOMIC_RELAXED);
+
+				counts[fn][cls] += c;
+				total += c;
+			}
 		}
 	}
-
-	/* Newton's iterations */
-	l = (A >> 1) + 1;
-	for (i = 0; i < iter; i++)
-		l = fixedpt_add(l, fixedpt_div(A, l)) >> 1;
-	if (invert)
-		return (fixedpt_div(FIXEDPT_ONE, l));
-	return (l);
+	return (total);
 }
 
-/* Returns the value exp(x), i.e. e^x of the given fixedpt number. */
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_exp(fixedpt x)
+/* Returns the name of a FIXEDPT_FN_* function, or NULL */
+_FIXEDPT_FUNCTYPE const char *fixedpt_errors_fn_name(int fn)
 {
-	fixedpt xabs, k, z, R, xp;
-	static const fixedpt LN2 = fixedpt_rconst(0.69314718055994530942);
-	static const fixedpt LN2_INV = fixedpt_rconst(1.4426950408889634074);
-	static const fixedpt EXP_P[5] = {
-		fixedpt_rconst(1.66666666666666019037e-01),
-		fixedpt_rconst(-2.77777777770155933842e-03),
-		fixedpt_rconst(6.61375632143793436117e-05),
-		fixedpt_rconst(-1.65339022054652515390e-06),
-		fixedpt_rconst(4.13813679705723846039e-08),
+	static const char *const names[FIXEDPT_FN_COUNT] = {
+		"mul", "fma", "div", "dw_to", "sqrt", "exp", "ln", "pow",
+		"asin", "acos", "cabs", "convert", "pack",
 	};
 
-	if (x == 0)
-		return (FIXEDPT_ONE);
-	xabs = fixedpt_abs(x);
-	k = fixedpt_mul(xabs, LN2_INV);
-	k += FIXEDPT_ONE_HALF;
-	k &= ~FIXEDPT_FMASK;
-	if (x < 0)
-		k = -k;
-	x -= fixedpt_mul(k, LN2);
-	z = fixedpt_mul(x, x);
-	/* Taylor */
-	R = FIXEDPT_TWO +
-	    fixedpt_mul(z, EXP_P[0] + fixedpt_mul(z, EXP_P[1] +
-	    fixedpt_mul(z, EXP_P[2] + fixedpt_mul(z, EXP_P[3] +
-	    fixedpt_mul(z, EXP_P[4])))));
-	xp = FIXEDPT_ONE + fixedpt_div(fixedpt_mul(x, FIXEDPT_TWO), R - x);
-	if (k < 0)
-		k = FIXEDPT_ONE >> (-k >> FIXEDPT_FBITS);
-	else
-		k = FIXEDPT_ONE << (k >> FIXEDPT_FBITS);
-	return (fixedpt_mul(k, xp));
+	return ((fn >= 0 && fn < FIXEDPT_FN_COUNT) ? names[fn] : NULL);
 }
 
-
-/* Returns the natural logarithm of the given fixedpt number. */
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_ln(fixedpt x)
+/* Returns the name of a FIXEDPT_ERR_* class, or NULL */
+_FIXEDPT_FUNCTYPE const char *fixedpt_errors_class_name(int cls)
 {
-	fixedpt log2, xi;
-	fixedpt f, s, z, w, R;
-	static const fixedpt LN2 = fixedpt_rconst(0.69314718055994530942);
-	static const fixedpt LG[7] = {
-		fixedpt_rconst(6.666666666666735130e-01),
-		fixedpt_rconst(3.999999999940941908e-01),
-		fixedpt_rconst(2.857142874366239149e-01),
-		fixedpt_rconst(2.222219843214978396e-01),
-		fixedpt_rconst(1.818357216161805012e-01),
-		fixedpt_rconst(1.531383769920937332e-01),
-		fixedpt_rconst(1.479819860511658591e-01)
+	static const char *const names[FIXEDPT_ERR_COUNT] = {
+		"domain", "overflow", "divzero", "saturate",
 	};
 
-	if (x < 0)
-		return (0);
-	if (x == 0)
-		return 0xffffffff;
-
-	log2 = 0;
-	xi = x;
-	while (xi > FIXEDPT_TWO) {
-		xi >>= 1;
-		log2++;
-	}
-	f = xi - FIXEDPT_ONE;
-	s = fixedpt_div(f, FIXEDPT_TWO + f);
-	z = fixedpt_mul(s, s);
-	w = fixedpt_mul(z, z);
-	R = fixedpt_mul(w, LG[1] + fixedpt_mul(w, LG[3]
-	    + fixedpt_mul(w, LG[5]))) + fixedpt_mul(z, LG[0]
-	    + fixedpt_mul(w, LG[2] + fixedpt_mul(w, LG[4]
-	    + fixedpt_mul(w, LG[6]))));
-	return (fixedpt_mul(LN2, (log2 << FIXEDPT_FBITS)) + f
-	    - fixedpt_mul(s, f - R));
+	return ((cls >= 0 && cls < FIXEDPT_ERR_COUNT) ? names[cls] : NULL);
 }
-	
+#else
+#define _FIXEDPT_CHECK(cond, fn, cls)	((void)0)
+#define _FIXEDPT_CHECK_N(n, fn, cls)	((void)0)
+#endif
 
-/* Returns the logarithm of the given base of the given fixedpt number */
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_log(fixedpt x, fixedpt base)
-{
-	return (fixedpt_div(fixedpt_ln(x), fixedpt_ln(base)));
-}
+/*
+ * Tracing.
+ *
+ * With FIXEDPT_TRACE, the FIXEDPT_TRACE_* functions count their calls,
+ * and time about one in FIXEDPT_TRACE_PERIOD with the cycle counter: the
+ * TSC on x86, which ticks at a fixed reference rate, or the virtual
+ * counter on AArch64. Elsewhere only the calls are counted. The gaps
+ * between the samples are random, so that they cannot lock onto a
+ * periodic pattern of inputs. A call that is not sampled costs a
+ * thread-local load, an increment and a decrement. The cycles of a
+ * sampled call include about two reads of the counter.
+ *
+ * The traced functions are compiled as _fixedpt_*_untraced, which is
+ * what the library calls itself, and their public names are wrappers,
+ * defined at the end of the implementation.
+ */
+#ifdef FIXEDPT_TRACE
+struct _fixedpt_trace_set {
+	uint64_t calls[FIXEDPT_TRACE_COUNT];
+	uint64_t cycles[FIXEDPT_TRACE_COUNT][FIXEDPT_TRACE_BUCKETS];
+	uint64_t mag[FIXEDPT_TRACE_COUNT][FIXEDPT_BITS + 1];
+	uint64_t mag_cycles[FIXEDPT_TRACE_COUNT][FIXEDPT_BITS + 1];
+};
 
+static struct _fixedpt_trace_set _fixedpt_trace_sets[FIXEDPT_TRACE_THREADS + 1];
+static unsigned int _fixedpt_trace_sets_used = 0;
+static _FIXEDPT_TLS struct _fixedpt_trace_set *_fixedpt_trace_own = NULL;
+static _FIXEDPT_TLS uint32_t _fixedpt_trace_wait[FIXEDPT_TRACE_COUNT];
+static _FIXEDPT_TLS uint32_t _fixedpt_trace_seed = 0;
 
-/* Return the power value (n^exp) of the given fixedpt numbers */
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_pow(fixedpt x, fixedpt exp)
+#define _FIXEDPT_TRACE_SHARED	(&_fixedpt_trace_sets[FIXEDPT_TRACE_THREADS])
+
+/* Returns the cycle counter, or 0 where there is none */
+_FIXEDPT_INLINE uint64_t _fixedpt_cycles(void)
 {
-	if (exp == 0)
-		return (FIXEDPT_ONE);
-	if (x < 0)
-		return 0;
-	return (fixedpt_exp(fixedpt_mul(fixedpt_ln(x), exp)));
+#if defined(__x86_64__) || defined(__i386__)
+	return (__builtin_ia32_rdtsc());
+#elif defined(__aarch64__)
+	uint64_t t;
+
+	__asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(t));
+	return (t);
+#else
+	return (0);
+#endif
 }
 
-/* Returns the sine of the given fixedpt number. 
- * Note: the loss of precision is extraordinary! */
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_sin(fixedpt angle)
+/* Draws the gap to the next sample of fn, returns the cycle counter */
+__attribute__((noinline, cold)) static uint64_t _fixedpt_trace_sample(int fn)
 {
-	/* Minimax coefficients */
-	/* These coefficients are precomputed and provide a high-accuracy approximation. */
-	static const fixedpt c[7] ={ 
-		fixedpt_rconst(1.0),
-		fixedpt_rconst(-0.16666666641626524), // -1/3!
-		fixedpt_rconst(0.008333333171954214), // 1/5!
-		fixedpt_rconst(-0.0001984126963009452), // -1/7!
-		fixedpt_rconst(2.755731884462877e-6), // 1/9!
-		fixedpt_rconst(-2.505210838544172e-8), // -1/11!
-		fixedpt_rconst(1.605904383682161e-10) // 1/13!
-	};
-
-    /* Perform angle normalization */
-    /* Step 1 : Normalize to [-2pi, 2pi] */
-	angle %= FIXEDPT_TWO_PI;
+	uint32_t x = _fixedpt_trace_seed;
 
-    /* Step 2 : Normalize to [-pi, pi] */
-    if (angle < -FIXEDPT_PI) { 
-        angle = fixedpt_add(angle, FIXEDPT_TWO_PI);
-	} else if (angle > FIXEDPT_PI) {
-        angle = fixedpt_sub(angle, FIXEDPT_TWO_PI);
-	}
-
-    /* Step 3 :  Normalize to [-pi/2, pi/2] */
-    if (angle > FIXEDPT_HALF_PI) {
-        angle = fixedpt_sub(FIXEDPT_PI, angle);
-        //flip_cos_sign = 1;
-    } else if (angle < -FIXEDPT_HALF_PI) {
-        angle = fixedpt_sub(-FIXEDPT_PI, angle);
-       // flip_cos_sign = 1;        
-    }
-
-    // Minimax polynomial approximation for sin(x)
-    fixedpt x2 = fixedpt_mul(angle, angle); // x^2
-    return (fixedpt_mul(angle, fixedpt_add(c[0], 
-			fixedpt_mul(x2, fixedpt_add(c[1],  
-			fixedpt_mul(x2, fixedpt_add(c[2], 
-			fixedpt_mul(x2, fixedpt_add(c[3],
-			fixedpt_mul(x2, fixedpt_add(c[4],
-			fixedpt_mul(x2, fixedpt_add(c[5],
-			fixedpt_mul(x2, c[6])
-			)))))))))))));
+	/* xorshift32 */
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	_fixedpt_trace_seed = x;
+	_fixedpt_trace_wait[fn] = FIXEDPT_TRACE_PERIOD / 2 + x % FIXEDPT_TRACE_PERIOD;
+	return (_fixedpt_cycles());
 }
 
-/* Returns the cosine of the given fixedpt number */
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_cos(fixedpt angle)
+/* Counts a call of fn from a thread without a set of its own */
+__attribute__((noinline, cold)) static uint64_t _fixedpt_trace_begin_slow(int fn)
 {
-	int flip_cos_sign = 0;
-
-	/* Minimax coefficients */
-	/* These coefficients are precomputed and provide a high-accuracy approximation. */
-	static const fixedpt c[7] ={ 
-		fixedpt_rconst(1.0),
-		fixedpt_rconst(-0.5), // -1/2!
-		fixedpt_rconst(0.04166666657946379), // 1/4!
-		fixedpt_rconst(-0.001388888894063317), // -1/6!
-		fixedpt_rconst(2.480158728947673e-5), // 1/8!
-		fixedpt_rconst(-2.755731435139066e-7), // -1/10!
-		fixedpt_rconst(2.087675440040727e-9) // 1/12!
-	};
-
-    /* Perform angle normalization */
-    /* Step 1 : Normalize to [-2pi, 2pi] */
-	angle %= FIXEDPT_TWO_PI;
+	struct _fixedpt_trace_set *set = _fixedpt_trace_own;
 
-    /* Step 2 : Normalize to [-pi, pi] */
-    if (angle < -FIXEDPT_PI) { 
-        angle = fixedpt_add(angle, FIXEDPT_TWO_PI);
-	} else if (angle > FIXEDPT_PI) {
-        angle = fixedpt_sub(angle, FIXEDPT_TWO_PI);
+	if (set == NULL) {
+		set = &_fixedpt_trace_sets[_fixedpt_claim(&_fixedpt_trace_sets_used, FIXEDPT_TRACE_THREADS)];
+		_fixedpt_trace_own = set;
+		_fixedpt_trace_seed = (uint32_t)((uintptr_t)&_fixedpt_trace_seed >> 3) | 1;
 	}
+	_fixedpt_count(&set->calls[fn], 1, set == _FIXEDPT_TRACE_SHARED);
+	if (_fixedpt_trace_wait[fn] != 0) {
+		_fixedpt_trace_wait[fn]--;
+		return (0);
+	}
+	return (_fixedpt_trace_sample(fn));
+}
 
-    /* Step 3 :  Normalize to [-pi/2, pi/2] */
-    if (angle > FIXEDPT_HALF_PI) {
-        angle = fixedpt_sub(FIXEDPT_PI, angle);
-        flip_cos_sign = 1;
-    } else if (angle < -FIXEDPT_HALF_PI) {
-        angle = fixedpt_sub(-FIXEDPT_PI, angle);
-       flip_cos_sign = 1;        
-    }
-    /* Minimax polynomial approximation for cos(x) */
-    fixedpt x2 = fixedpt_mul(angle, angle); // x^2
-
-	fixedpt val = fixedpt_add(c[0], 
-		fixedpt_mul(x2, fixedpt_add(c[1],
-		fixedpt_mul(x2, fixedpt_add(c[2],
-		fixedpt_mul(x2, fixedpt_add(c[3],
-		fixedpt_mul(x2, fixedpt_add(c[4],
-		fixedpt_mul(x2, fixedpt_add(c[5],
-		fixedpt_mul(x2, c[6])
-	)))))))))));
+/* Counts a call of fn, returns the cycle counter if it is to be timed, else 0 */
+_FIXEDPT_INLINE uint64_t _fixedpt_trace_begin(int fn)
+{
+	struct _fixedpt_trace_set *set = _fixedpt_trace_own;
 
-	return((flip_cos_sign == 0)?val:-val);
+	if (__builtin_expect(set == NULL || set == _FIXEDPT_TRACE_SHARED, 0))
+		return (_fixedpt_trace_begin_slow(fn));
+	_fixedpt_count(&set->calls[fn], 1, 0);
+	if (__builtin_expect(_fixedpt_trace_wait[fn] != 0, 1)) {
+		_fixedpt_trace_wait[fn]--;
+		return (0);
+	}
+	return (_fixedpt_trace_sample(fn));
 }
 
-/* Returns the tangens of the given fixedpt number */
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_tan(fixedpt angle)
+/* Returns the bucket of a duration of c cycles */
+_FIXEDPT_INLINE int _fixedpt_trace_bucket(uint64_t c)
 {
-	return fixedpt_div(fixedpt_sin(angle), fixedpt_cos(angle));
+	int e, i;
+
+	if (c < 4)
+		return ((int)c);
+	e = 63 - __builtin_clzll(c);
+	i = 4 * (e - 1) + (int)((c >> (e - 2)) & 3);
+	return (i < FIXEDPT_TRACE_BUCKETS ? i : FIXEDPT_TRACE_BUCKETS - 1);
 }
 
-// Minimax polynomial approximation for arctan(z) with 7 terms
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_atan(fixedpt z) 
-{
-    // Example coefficients for a degree-7 polynomial approximation
-    // static fixedpt E[7] = {
-    //     fixedpt_rconst(1.0),
-    //     fixedpt_rconst(-0.3333333333333333),  // -1/3
-    //     fixedpt_rconst(0.2),                 // 1/5
-    //     fixedpt_rconst(-0.1428571428571429), // -1/7
-    //     fixedpt_rconst(0.1111111111111111), // 1/9
-    //     fixedpt_rconst(-0.0909090909090909), // -1/11
-    //     fixedpt_rconst(0.0769230769230769) // 1/13
-    // };
-	// Constatnt in Intel Pentium
-    static fixedpt E[7] = {
-        fixedpt_rconst(1.0),
-        fixedpt_rconst(-0.3333333333),  // -1/3
-        fixedpt_rconst(0.2),                 // 1/5
-        fixedpt_rconst(-0.1428571429), // -1/7
-        fixedpt_rconst(0.1111111089), // 1/9
-        fixedpt_rconst(-0.0909075848), // -1/11
-        fixedpt_rconst(0.0764169081) // 1/13
-    };
-
-	static fixedpt bias_atan[32] = {
-		fixedpt_rconst(0.0000000000),  // atain(0/32)
-		fixedpt_rconst(0.0312398334),  // atain(1/32)
-		fixedpt_rconst(0.0624188100),  // atain(2/32)
-		fixedpt_rconst(0.0934767812),  // atain(3/32)
-		fixedpt_rconst(0.1243549945),  // atain(4/32)
-		fixedpt_rconst(0.1549967419),  // atain(5/32)
-		fixedpt_rconst(0.1853479500),  // atain(6/32)
-		fixedpt_rconst(0.2153576997),  // atain(7/32)
-		fixedpt_rconst(0.2449786631),  // atain(8/32)
-		fixedpt_rconst(0.2741674511),  // atain(9/32)
-		fixedpt_rconst(0.3028848684),  // atain(10/32)
-		fixedpt_rconst(0.3310960767),  // atain(11/32)
-		fixedpt_rconst(0.3587706703),  // atain(12/32)
-		fixedpt_rconst(0.3858826694),  // atain(13/32)
-		fixedpt_rconst(0.4124104416),  // atain(14/32)
-		fixedpt_rconst(0.4383365599),  // atain(15/32)
-		fixedpt_rconst(0.4636476090),  // atain(16/32)
-		fixedpt_rconst(0.4883339511),  // atain(17/32)
-		fixedpt_rconst(0.5123894603),  // atain(18/32)
-		fixedpt_rconst(0.5358112380),  // atain(19/32)
-		fixedpt_rconst(0.5585993153),  // atain(20/32)
-		fixedpt_rconst(0.5807563536),  // atain(21/32)
-		fixedpt_rconst(0.6022873461),  // atain(22/32)
-		fixedpt_rconst(0.6231993299),  // atain(23/32)
-		fixedpt_rconst(0.6435011088),  // atain(24/32)
-		fixedpt_rconst(0.6632029927),  // atain(25/32)
-		fixedpt_rconst(0.6823165549),  // atain(26/32)
-		fixedpt_rconst(0.7008544079),  // atain(27/32)
-		fixedpt_rconst(0.7188299996),  // atain(28/32)
-		fixedpt_rconst(0.7362574290),  // atain(29/32)
-		fixedpt_rconst(0.7531512810),  // atain(30/32)
-		fixedpt_rconst(0.7695264804)  // atain(31/32)
-	};
+/* Records a sampled call of fn that started at cycle t0, m being the largest |argument| */
+__attribute__((noinline, cold)) static void _fixedpt_trace_end(int fn, uint64_t t0, fixedptu m)
+{
+	uint64_t c = _fixedpt_cycles() - t0;
+	struct _fixedpt_trace_set *set = _fixedpt_trace_own;
+	int shared = (set == _FIXEDPT_TRACE_SHARED);
+	int b = (m == 0) ? 0 : 64 - __builtin_clzll((uint64_t)m);
 
-	int signflip_flag = 0, inverse_flag = 0;
-    fixedpt theta, factor_c = 0;
+	_fixedpt_count(&set->cycles[fn][_fixedpt_trace_bucket(c)], 1, shared);
+	_fixedpt_count(&set->mag[fn][b], 1, shared);
+	_fixedpt_count(&set->mag_cycles[fn][b], c, shared);
+}
 
-    // Reduce z to [0, inf] if necessary
-	if(z < 0) {
-		z = fixedpt_abs(z);
-		signflip_flag = 1;
-	}
-	
-	// Reduce z to [0, 1]
-    if (z > FIXEDPT_ONE) {
-        // Use arctan(z) = π/2 - arctan(1/z) for z > 1
-        z = fixedpt_div(FIXEDPT_ONE, z);
-		inverse_flag = 1;
-    }
+/* Returns |a| */
+_FIXEDPT_INLINE fixedptu _fixedpt_trace_mag(fixedpt a)
+{
+	return (a < 0 ? (fixedptu)-(fixedptu)a : (fixedptu)a);
+}
+
+/*
+ * Returns the fewest cycles of bucket i, 0 <= i < FIXEDPT_TRACE_BUCKETS.
+ * Buckets 0 to 3 hold 0 to 3 cycles, and each following group of four
+ * splits an octave [2^e, 2^(e + 1)) into quarters. The last bucket also
+ * holds everything longer.
+ */
+_FIXEDPT_FUNCTYPE uint64_t fixedpt_trace_bucket_cycles(int i)
+{
+	if (i < 4)
+		return ((uint64_t)i);
+	return ((uint64_t)(4 + i % 4) << (i / 4 - 1));
+}
+
+/*
+ * Sums the trace of function fn over all threads, including those that
+ * have exited, into st. Returns 0, or -1 if fn is not a FIXEDPT_TRACE_*
+ * function. The counts only grow, so rates are the differences between
+ * two snapshots. A snapshot only reads the counters, and may miss the
+ * calls made while it runs.
+ */
+_FIXEDPT_FUNCTYPE int fixedpt_trace_snapshot(int fn, fixedpt_trace_stats *st)
+{
+	uint64_t seen, r50, r99;
+	int t, i;
+
+	if (fn < 0 || fn >= FIXEDPT_TRACE_COUNT)
+		return (-1);
+	st->calls = st->sampled = 0;
+	for (i = 0; i < FIXEDPT_TRACE_BUCKETS; i++)
+		st->cycles[i] = 0;
+	for (i = 0; i <= FIXEDPT_BITS; i++)
+		st->mag[i] = st->mag_cycles[i] = 0;
+	for (t = 0; t <= FIXEDPT_TRACE_THREADS; t++) {
+		const struct _fixedpt_trace_set *set = &_fixedpt_trace_sets[t];
+
+		st->calls += __atomic_load_n(&set->calls[fn], __ATOMIC_RELAXED);
+		for (i = 0; i < FIXEDPT_TRACE_BUCKETS; i++)
+			st->cycles[i] += __atomic_load_n(&set->cycles[fn][i], __ATOMIC_RELAXED);
+		for (i = 0; i <= FIXEDPT_BITS; i++) {
+			st->mag[i] += __atomic_load_n(&set->mag[fn][i], __ATOMIC_RELAXED);
+			st->mag_cycles[i] += __atomic_load_n(&set->mag_cycles[fn][i], __ATOMIC_RELAXED);
+		}
+	}
+	for (i = 0; i < FIXEDPT_TRACE_BUCKETS; i++)
+		st->sampled += st->cycles[i];
+
+	/* The ranks of the percentiles, rounded up */
+	r50 = (st->sampled + 1) / 2;
+	r99 = st->sampled - st->sampled / 100;
+	st->p50 = st->p99 = 0;
+	for (i = 0, seen = 0; i < FIXEDPT_TRACE_BUCKETS && seen < r99; i++) {
+		uint64_t top = (i + 1 < FIXEDPT_TRACE_BUCKETS) ?
+		    fixedpt_trace_bucket_cycles(i + 1) - 1 : fixedpt_trace_bucket_cycles(i);
+
+		seen += st->cycles[i];
+		if (seen >= r50 && st->p50 == 0)
+			st->p50 = top;
+		if (seen >= r99)
+			st->p99 = top;
+	}
+	return (0);
+}
+
+/* Returns the name of a FIXEDPT_TRACE_* function, or NULL */
+_FIXEDPT_FUNCTYPE const char *fixedpt_trace_name(int fn)
+{
+	static const char *const names[FIXEDPT_TRACE_COUNT] = {
+		"mul", "div", "fma", "mla", "mls", "sqrt", "exp", "ln", "log",
+		"pow", "sin", "cos", "sincos", "tan", "asin", "acos", "atan",
+		"atan2",
+	};
+
+	return ((fn >= 0 && fn < FIXEDPT_TRACE_COUNT) ? names[fn] : NULL);
+}
+
+#define fixedpt_mul	_fixedpt_mul_untraced
+#define fixedpt_div	_fixedpt_div_untraced
+#define fixedpt_fma	_fixedpt_fma_untraced
+#define fixedpt_mla	_fixedpt_mla_untraced
+#define fixedpt_mls	_fixedpt_mls_untraced
+#define fixedpt_sqrt	_fixedpt_sqrt_untraced
+#define fixedpt_exp	_fixedpt_exp_untraced
+#define fixedpt_ln	_fixedpt_ln_untraced
+#define fixedpt_log	_fixedpt_log_untraced
+#define fixedpt_pow	_fixedpt_pow_untraced
+#define fixedpt_sin	_fixedpt_sin_untraced
+#define fixedpt_cos	_fixedpt_cos_untraced
+#define fixedpt_sincos	_fixedpt_sincos_untraced
+#define fixedpt_tan	_fixedpt_tan_untraced
+#define fixedpt_asin	_fixedpt_asin_untraced
+#define fixedpt_acos	_fixedpt_acos_untraced
+#define fixedpt_atan	_fixedpt_atan_untraced
+#define fixedpt_atan2	_fixedpt_atan2_untraced
+#endif
+
+
+/* Multiplies two fixedpt numbers, returns the result. */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_mul(fixedpt A, fixedpt B)
+{
+	fixedptd product = (fixedptd)A * (fixedptd)B;
+
+	/*
+	 * Round to nearest: the product shifted by FBITS plus the bit below.
+	 * Written as ((p >> (FBITS - 1)) + 1) >> 1, which is the same value,
+	 * because compilers map that form of a 16-bit Q1.15 loop onto the
+	 * packed multiply-high-round instruction (pmulhrsw).
+	 */
+	fixedptd r = ((product >> (FIXEDPT_FBITS - 1)) + 1) >> 1;
+
+	_FIXEDPT_CHECK(r != (fixedpt)r, FIXEDPT_FN_MUL, FIXEDPT_ERR_OVERFLOW);
+	return ((fixedpt)r);
+}
+
+
+/* Divides two fixedpt numbers, returns the result. */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_div(fixedpt A, fixedpt B)
+{
+#ifdef FIXEDPT_ERROR_COUNTERS
+	fixedptd q;
+
+	_FIXEDPT_CHECK(B == 0, FIXEDPT_FN_DIV, FIXEDPT_ERR_DIVZERO);
+	q = ((fixedptd)A << FIXEDPT_FBITS) / (fixedptd)B;
+	_FIXEDPT_CHECK(q != (fixedpt)q, FIXEDPT_FN_DIV, FIXEDPT_ERR_OVERFLOW);
+	return ((fixedpt)q);
+#else
+	return (((fixedptd)A << FIXEDPT_FBITS) / (fixedptd)B);
+#endif
+}
+
+/*
+ * Returns A * B + C. The product is kept in fixedptd and the sum is
+ * rounded to nearest once, so this is the primitive the polynomial
+ * evaluations below are built on.
+ */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_fma(fixedpt A, fixedpt B, fixedpt C)
+{
+	fixedptd acc = (fixedptd)A * (fixedptd)B + ((fixedptd)C << FIXEDPT_FBITS);
+	fixedptd r = ((acc >> (FIXEDPT_FBITS - 1)) + 1) >> 1;
+
+	_FIXEDPT_CHECK(r != (fixedpt)r, FIXEDPT_FN_FMA, FIXEDPT_ERR_OVERFLOW);
+	return ((fixedpt)r);
+}
+
+
+/* Returns acc + A * B, rounding once */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_mla(fixedpt acc, fixedpt A, fixedpt B)
+{
+	return (fixedpt_fma(A, B, acc));
+}
+
+
+/* Returns acc - A * B, rounding once */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_mls(fixedpt acc, fixedpt A, fixedpt B)
+{
+	fixedptd r = ((fixedptd)acc << FIXEDPT_FBITS) - (fixedptd)A * (fixedptd)B;
+
+	r = ((r >> (FIXEDPT_FBITS - 1)) + 1) >> 1;
+	_FIXEDPT_CHECK(r != (fixedpt)r, FIXEDPT_FN_FMA, FIXEDPT_ERR_OVERFLOW);
+	return ((fixedpt)r);
+}
+
+/*
+ * Note: adding and substracting fixedpt numbers can be done by using
+ * the regular integer operators + and -.
+ */
+
+/* Converts a fixedpt number to a double-word, exactly */
+_FIXEDPT_FUNCTYPE fixedpt_dw fixedpt_dw_from(fixedpt A)
+{
+	fixedpt_dw r;
+
+	r.lo = (fixedptu)((fixedptu)A << FIXEDPT_FBITS);
+	r.hi = (fixedpt)(A >> (FIXEDPT_BITS - FIXEDPT_FBITS));
+	return (r);
+}
+
+/* Rounds a double-word to the nearest fixedpt, saturating if out of range */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_dw_to(fixedpt_dw A)
+{
+	fixedptu lo = (fixedptu)(A.lo + ((fixedptu)1 << (FIXEDPT_FBITS - 1)));
+	fixedpt hi = (fixedpt)((fixedptu)A.hi + (lo < A.lo));
+	fixedpt r = (fixedpt)((fixedptu)(lo >> FIXEDPT_FBITS) |
+	    (fixedptu)((fixedptu)hi << (FIXEDPT_BITS - FIXEDPT_FBITS)));
+
+	/* The bits shifted out of hi must all be copies of the sign of r */
+	if ((hi >> (FIXEDPT_FBITS - 1)) != (r < 0 ? -1 : 0)) {
+		_FIXEDPT_CHECK(1, FIXEDPT_FN_DW, FIXEDPT_ERR_SATURATE);
+		return (hi < 0 ? FIXEDPT_MIN : FIXEDPT_MAX);
+	}
+	return (r);
+}
+
+/* Adds two double-words */
+_FIXEDPT_FUNCTYPE fixedpt_dw fixedpt_dw_add(fixedpt_dw A, fixedpt_dw B)
+{
+	fixedpt_dw r;
+
+	r.lo = (fixedptu)(A.lo + B.lo);
+	r.hi = (fixedpt)((fixedptu)A.hi + (fixedptu)B.hi + (r.lo < A.lo));
+	return (r);
+}
+
+/* Subtracts the double-word B from A */
+_FIXEDPT_FUNCTYPE fixedpt_dw fixedpt_dw_sub(fixedpt_dw A, fixedpt_dw B)
+{
+	fixedpt_dw r;
+
+	r.lo = (fixedptu)(A.lo - B.lo);
+	r.hi = (fixedpt)((fixedptu)A.hi - (fixedptu)B.hi - (A.lo < B.lo));
+	return (r);
+}
+
+/* Returns the exact product of two fixedpt numbers as a double-word */
+_FIXEDPT_FUNCTYPE fixedpt_dw fixedpt_dw_mul(fixedpt A, fixedpt B)
+{
+	fixedptd product = (fixedptd)A * (fixedptd)B;
+	fixedpt_dw r;
+
+	r.lo = (fixedptu)product;
+	r.hi = (fixedpt)(product >> FIXEDPT_BITS);
+	return (r);
+}
+
+/* Returns acc + A * B, without rounding */
+_FIXEDPT_FUNCTYPE fixedpt_dw fixedpt_dw_fma(fixedpt_dw acc, fixedpt A, fixedpt B)
+{
+	return (fixedpt_dw_add(acc, fixedpt_dw_mul(A, B)));
+}
+
+/**
+ * Convert the given fixedpt number to a decimal string.
+ * The max_dec argument specifies how many decimal digits to the right
+ * of the decimal point to generate. If set to -1, the "default" number
+ * of decimal digits will be used (2 or 4 for 16-bit and 32-bit fixedpt
+ * widths, depending on FIXEDPT_WBITS, 10 for 64-bit fixedpt width);
+ * If set to -2, "all" of the digits will
+ * be returned, meaning there will be invalid, bogus digits outside the
+ * specified precisions.
+ */
+_FIXEDPT_FUNCTYPE void fixedpt_str(fixedpt A, char *str, int max_dec)
+{
+	int ndec = 0, slen = 0;
+	char tmp[12] = {0};
+	fixedptud fr, ip;
+	const fixedptud one = (fixedptud)1 << FIXEDPT_BITS;
+	const fixedptud mask = one - 1;
+
+	if (max_dec == -1)
+#if FIXEDPT_BITS == 16
+#if FIXEDPT_WBITS > 6
+		max_dec = 2;
+#else
+		max_dec = 4;
+#endif
+#elif FIXEDPT_BITS == 32
+#if FIXEDPT_WBITS > 16
+		max_dec = 2;
+#else
+		max_dec = 4;
+#endif
+#elif FIXEDPT_BITS == 64
+		max_dec = 10;
+#else
+#error Invalid width
+#endif
+	else if (max_dec == -2)
+		max_dec = 15;
+
+	if (A < 0) {
+		str[slen++] = '-';
+		A *= -1;
+	}
+
+	ip = fixedpt_toint(A);
+	do {
+		tmp[ndec++] = '0' + ip % 10;
+		ip /= 10;
+	} while (ip != 0);
+
+	while (ndec > 0)
+		str[slen++] = tmp[--ndec];
+	str[slen++] = '.';
+
+	fr = (fixedpt_fracpart(A) << FIXEDPT_WBITS) & mask;
+	do {
+		fr = (fr & mask) * 10;
+
+		str[slen++] = '0' + (fr >> FIXEDPT_BITS) % 10;
+		ndec++;
+	} while (fr != 0 && ndec < max_dec);
+
+	if (ndec > 1 && str[slen-1] == '0')
+		str[slen-1] = '\0'; /* cut off trailing 0 */
+	else
+		str[slen] = '\0';
+}
+
+
+/* Converts the given fixedpt number into a string, using a static
+ * (non-threadsafe) string buffer */
+_FIXEDPT_FUNCTYPE char* fixedpt_cstr(const fixedpt A, const int max_dec)
+{
+	static char str[25];
+
+	fixedpt_str(A, str, max_dec);
+	return (str);
+}
+
+/* Returns the index of the highest set bit of x, which must not be 0 */
+_FIXEDPT_INLINE int _fixedpt_msb(fixedptu x)
+{
+#if defined(__GNUC__) && FIXEDPT_BITS == 64
+	return (63 - __builtin_clzll(x));
+#elif defined(__GNUC__)
+	return (31 - __builtin_clz(x));
+#else
+	int b = 0;
+
+	while (x >>= 1)
+		b++;
+	return (b);
+#endif
+}
+
+/*
+ * Returns sqrt(a) rounded to nearest, for a < 2^(2 * FIXEDPT_BITS - 2).
+ * In 16-bit builds this is a bit-by-bit loop of fixed count and without
+ * branches, unrolled so that it vectorizes at -O2 as well; wider builds
+ * take Newton's iterations, whose few divisions beat 31 or 63 dependent
+ * steps.
+ */
+_FIXEDPT_INLINE fixedptud _fixedpt_isqrt(fixedptud a)
+{
+#if FIXEDPT_BITS == 16
+	fixedptud r = 0, b = (fixedptud)1 << (2 * FIXEDPT_BITS - 4);
+	int i;
+
+	_FIXEDPT_UNROLL
+	for (i = 0; i < FIXEDPT_BITS - 1; i++, b >>= 2) {
+		fixedptud t = r + b;
+		fixedptud m = (fixedptud)0 - (a >= t);
+
+		a -= t & m;
+		r = (r >> 1) + (b & m);
+	}
+	/* a is now the remainder, and (r + 1/2)^2 = r^2 + r + 1/4 */
+	return (r + (a > r));
+#else
+	fixedptu hi = (fixedptu)(a >> FIXEDPT_BITS);
+	fixedptud r, next;
+	int b;
+
+	if (a == 0)
+		return (0);
+	b = (hi != 0) ? FIXEDPT_BITS + _fixedpt_msb(hi) : _fixedpt_msb((fixedptu)a);
+
+	/* The iterations fall from 2^(b/2 + 1) > sqrt(a) to floor(sqrt(a)) */
+	r = (fixedptud)1 << ((b >> 1) + 1);
+	for (;;) {
+		next = (r + a / r) >> 1;
+		if (next >= r)
+			break;
+		r = next;
+	}
+	return (r + (a - r * r > r));
+#endif
+}
+
+/*
+ * Returns the square root of the given number, rounded to nearest, or -1
+ * in case of error. That is the integer square root of A * 2^FIXEDPT_FBITS,
+ * which is below 2^(2 * FIXEDPT_BITS - 2) in every format, so there is no
+ * reciprocal to overflow where FIXEDPT_WBITS is small.
+ */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_sqrt(fixedpt A)
+{
+	if (A < 0) {
+		_FIXEDPT_CHECK(1, FIXEDPT_FN_SQRT, FIXEDPT_ERR_DOMAIN);
+		return (-1);
+	}
+	return ((fixedpt)_fixedpt_isqrt((fixedptud)A << FIXEDPT_FBITS));
+}
+
+/*
+ * Polynomial evaluation engine.
+ *
+ * The transcendental functions reduce their argument, then evaluate a
+ * polynomial in an internal format with _FIXEDPT_PBITS fraction bits
+ * (a sign and one whole bit): the bits below FIXEDPT_FBITS are guard
+ * bits, which the result loses only in its final rounding. Arguments are
+ * reduced so that every power and partial sum stays below 2. Where
+ * fixedpt has fewer than 6 whole bits the format is a _fixedpt_p of
+ * twice the width if possible, so that the guard bits do not run out,
+ * and results beyond the fixedpt range saturate rather than wrap.
+ *
+ * The degrees are chosen so that the truncation error of each series
+ * stays below a quarter LSB of the result. That depends on FIXEDPT_FBITS
+ * for sin, cos, ln and atan, whose polynomials are bounded by about 1.6;
+ * e^r is scaled by up to 2^FIXEDPT_WBITS, so it needs about FIXEDPT_BITS
+ * significant bits in every format. The coefficients are doubles, which
+ * limits all of them to about 2^-54 beyond FIXEDPT_FBITS = 52.
+ */
+#ifdef _FIXEDPT_WIDE_CORE
+#define _FIXEDPT_PBITS	(2 * FIXEDPT_BITS - 2)
+#else
+#define _FIXEDPT_PBITS	(FIXEDPT_BITS - 2)
+#endif
+#define _fixedpt_pconst(R) ((_fixedpt_p)((R) * (double)((_fixedpt_pud)1 << _FIXEDPT_PBITS) + \
+	((R) >= 0 ? 0.5 : -0.5)))
+
+#if FIXEDPT_BITS == 16
+#define _FIXEDPT_EXP_DEG	5
+#elif FIXEDPT_BITS == 32
+#define _FIXEDPT_EXP_DEG	8
+#else
+#define _FIXEDPT_EXP_DEG	13
+#endif
+
+#if FIXEDPT_FBITS <= 8
+#define _FIXEDPT_SIN_DEG	3
+#define _FIXEDPT_COS_DEG	3
+#define _FIXEDPT_LN_DEG		2
+#define _FIXEDPT_ATAN_DEG	1
+#elif FIXEDPT_FBITS <= 13
+#define _FIXEDPT_SIN_DEG	4
+#define _FIXEDPT_COS_DEG	4
+#define _FIXEDPT_LN_DEG		2
+#define _FIXEDPT_ATAN_DEG	1
+#elif FIXEDPT_FBITS <= 18
+#define _FIXEDPT_SIN_DEG	5
+#define _FIXEDPT_COS_DEG	5
+#define _FIXEDPT_LN_DEG		4
+#define _FIXEDPT_ATAN_DEG	2
+#elif FIXEDPT_FBITS <= 24
+#define _FIXEDPT_SIN_DEG	6
+#define _FIXEDPT_COS_DEG	6
+#define _FIXEDPT_LN_DEG		4
+#define _FIXEDPT_ATAN_DEG	3
+#elif FIXEDPT_FBITS <= 32
+#define _FIXEDPT_SIN_DEG	7
+#define _FIXEDPT_COS_DEG	8
+#define _FIXEDPT_LN_DEG		6
+#define _FIXEDPT_ATAN_DEG	4
+#elif FIXEDPT_FBITS <= 40
+#define _FIXEDPT_SIN_DEG	8
+#define _FIXEDPT_COS_DEG	9
+#define _FIXEDPT_LN_DEG		7
+#define _FIXEDPT_ATAN_DEG	5
+#elif FIXEDPT_FBITS <= 48
+#define _FIXEDPT_SIN_DEG	9
+#define _FIXEDPT_COS_DEG	10
+#define _FIXEDPT_LN_DEG		8
+#define _FIXEDPT_ATAN_DEG	6
+#else
+#define _FIXEDPT_SIN_DEG	10
+#define _FIXEDPT_COS_DEG	11
+#define _FIXEDPT_LN_DEG		9
+#define _FIXEDPT_ATAN_DEG	7
+#endif
+
+/* Returns A * B + C, all with prec fraction bits, rounded once */
+_FIXEDPT_INLINE _fixedpt_p _fixedpt_pfma(_fixedpt_p A, _fixedpt_p B, _fixedpt_p C, int prec)
+{
+	_fixedpt_pd acc = (_fixedpt_pd)A * (_fixedpt_pd)B + ((_fixedpt_pd)C << prec);
+
+	return ((_fixedpt_p)((acc + (((_fixedpt_pd)1 << prec) >> 1)) >> prec));
+}
+
+_FIXEDPT_INLINE _fixedpt_p _fixedpt_pmul(_fixedpt_p A, _fixedpt_p B, int prec)
+{
+	return (_fixedpt_pfma(A, B, 0, prec));
+}
+
+/* Rounds a number with _FIXEDPT_PBITS fraction bits to fixedpt, saturating */
+_FIXEDPT_INLINE fixedpt _fixedpt_pround(_fixedpt_pd A)
+{
+	const int shift = _FIXEDPT_PBITS - FIXEDPT_FBITS;
+	_fixedpt_pd r = (A + (((_fixedpt_pd)1 << shift) >> 1)) >> shift;
+
+	return ((r > FIXEDPT_MAX) ? FIXEDPT_MAX : (r < FIXEDPT_MIN) ? FIXEDPT_MIN : (fixedpt)r);
+}
+
+/*
+ * Returns c[0] + c[1] * x + ... + c[deg] * x^deg, where x and the
+ * coefficients have prec fraction bits. Every step is a multiply-add
+ * rounded once. deg is meant to be a constant, so that the loops unroll.
+ *
+ * FIXEDPT_POLY_HORNER is one serial chain of deg multiply-adds.
+ * FIXEDPT_POLY_ESTRIN sums independent pairs c[i] + c[i+1] * x, then
+ * pairs of those with x^2, x^4, ..., so the dependency chain is only
+ * about 2 * log2(deg) multiplies long, at the cost of log2(deg) extra
+ * squarings; it requires deg < 16.
+ */
+_FIXEDPT_INLINE _fixedpt_p _fixedpt_poly(_fixedpt_p x, const _fixedpt_p *c, int deg, int prec, int scheme)
+{
+	_fixedpt_p t[16] = {0};
+	int i, n;
+
+	if (scheme == FIXEDPT_POLY_HORNER || deg < 2 || deg > 15) {
+		_fixedpt_p acc = c[deg];
+
+		_FIXEDPT_UNROLL
+		for (i = deg - 1; i >= 0; i--)
+			acc = _fixedpt_pfma(acc, x, c[i], prec);
+		return (acc);
+	}
+
+	n = deg + 1;
+	_FIXEDPT_UNROLL
+	for (i = 0; 2 * i + 1 < n; i++)
+		t[i] = _fixedpt_pfma(c[2 * i + 1], x, c[2 * i], prec);
+	if (n & 1)
+		t[i] = c[n - 1];
+	_FIXEDPT_UNROLL
+	for (n = (n + 1) >> 1; n > 1; n = (n + 1) >> 1) {
+		x = _fixedpt_pmul(x, x, prec);
+		_FIXEDPT_UNROLL
+		for (i = 0; 2 * i + 1 < n; i++)
+			t[i] = _fixedpt_pfma(t[2 * i + 1], x, t[2 * i], prec);
+		if (n & 1)
+			t[i] = t[n - 1];
+	}
+	return (t[0]);
+}
+
+/*
+ * Evaluates the polynomial c[0] + c[1] * x + ... + c[deg] * x^deg, whose
+ * coefficients are fixedpt numbers, with the given scheme.
+ */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_poly(fixedpt x, const fixedpt *c, int deg, int scheme)
+{
+#ifdef _FIXEDPT_WIDE_CORE
+	/* The core takes _fixedpt_p coefficients, and ESTRIN at most 16 */
+	_fixedpt_p w[16] = {0};
+	fixedpt acc;
+	int i;
+
+	if (deg > 15) {
+		for (acc = c[deg], i = deg - 1; i >= 0; i--)
+			acc = (fixedpt)_fixedpt_pfma(acc, x, c[i], FIXEDPT_FBITS);
+		return (acc);
+	}
+	for (i = 0; i <= deg; i++)
+		w[i] = c[i];
+	return ((fixedpt)_fixedpt_poly(x, w, deg, FIXEDPT_FBITS, scheme));
+#else
+	return (_fixedpt_poly(x, c, deg, FIXEDPT_FBITS, scheme));
+#endif
+}
+
+
+/* Returns the value exp(x), i.e. e^x of the given fixedpt number. */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_exp(fixedpt x)
+{
+	static const _fixedpt_p LN2 = _fixedpt_pconst(0.69314718055994530942);
+	/* 1 / ln(2) with FIXEDPT_FBITS fraction bits, which Q1 cannot hold */
+	static const _fixedpt_p LN2_INV = (_fixedpt_p)(1.4426950408889634074 *
+	    (double)((fixedptud)1 << FIXEDPT_FBITS) + 0.5);
+	/* Taylor series of e^r, |r| <= ln(2) / 2 */
+	static const _fixedpt_p EXP_P[14] = {
+		_fixedpt_pconst(1.0),	/* 1/0! */
+		_fixedpt_pconst(1.0),	/* 1/1! */
+		_fixedpt_pconst(0.5),	/* 1/2! */
+		_fixedpt_pconst(0.16666666666666666),	/* 1/3! */
+		_fixedpt_pconst(0.041666666666666664),	/* 1/4! */
+		_fixedpt_pconst(0.008333333333333333),	/* 1/5! */
+		_fixedpt_pconst(0.001388888888888889),	/* 1/6! */
+		_fixedpt_pconst(0.0001984126984126984),	/* 1/7! */
+		_fixedpt_pconst(2.48015873015873e-05),	/* 1/8! */
+		_fixedpt_pconst(2.7557319223985893e-06),	/* 1/9! */
+		_fixedpt_pconst(2.755731922398589e-07),	/* 1/10! */
+		_fixedpt_pconst(2.505210838544172e-08),	/* 1/11! */
+		_fixedpt_pconst(2.08767569878681e-09),	/* 1/12! */
+		_fixedpt_pconst(1.6059043836821613e-10),	/* 1/13! */
+	};
+	fixedpt k;
+	_fixedpt_p r, p;
+	_fixedpt_pd v;
+	int shift;
+
+	/* x = k * ln(2) + r, e^x = 2^k * e^r */
+	k = (fixedpt)(((((_fixedpt_pd)x * LN2_INV) >> FIXEDPT_FBITS) +
+	    FIXEDPT_ONE_HALF) >> FIXEDPT_FBITS);
+	if (k > FIXEDPT_WBITS) {
+		_FIXEDPT_CHECK(1, FIXEDPT_FN_EXP, FIXEDPT_ERR_SATURATE);
+		return (FIXEDPT_MAX);
+	}
+	/* Below that 2^k * e^r rounds to 0, and k may not fit in an int */
+	if (k < -FIXEDPT_FBITS - 1)
+		return (0);
+	r = (_fixedpt_p)(((_fixedpt_pd)x << (_FIXEDPT_PBITS - FIXEDPT_FBITS)) -
+	    (_fixedpt_pd)k * LN2);
+	p = _fixedpt_poly(r, EXP_P, _FIXEDPT_EXP_DEG, _FIXEDPT_PBITS,
+	    FIXEDPT_POLY_SCHEME);
+
+	shift = _FIXEDPT_PBITS - FIXEDPT_FBITS - (int)k;
+	if (shift < 0)
+		v = (_fixedpt_pd)p << -shift;
+	else
+		v = ((_fixedpt_pd)p + (((_fixedpt_pd)1 << shift) >> 1)) >> shift;
+	_FIXEDPT_CHECK(v > FIXEDPT_MAX, FIXEDPT_FN_EXP, FIXEDPT_ERR_SATURATE);
+	return (v > FIXEDPT_MAX ? FIXEDPT_MAX : (fixedpt)v);
+}
+
+
+/* Returns the natural logarithm of the given fixedpt number. */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_ln(fixedpt x)
+{
+	static const _fixedpt_p LN2 = _fixedpt_pconst(0.69314718055994530942);
+	static const _fixedpt_p SQRT2 = _fixedpt_pconst(1.41421356237309504880);
+	/* Series of atanh(s) / s in s^2, |s| <= 3 - 2 * sqrt(2) */
+	static const _fixedpt_p LN_P[10] = {
+		_fixedpt_pconst(1.0),	/* 1/1 */
+		_fixedpt_pconst(0.3333333333333333),	/* 1/3 */
+		_fixedpt_pconst(0.2),	/* 1/5 */
+		_fixedpt_pconst(0.14285714285714285),	/* 1/7 */
+		_fixedpt_pconst(0.1111111111111111),	/* 1/9 */
+		_fixedpt_pconst(0.09090909090909091),	/* 1/11 */
+		_fixedpt_pconst(0.07692307692307693),	/* 1/13 */
+		_fixedpt_pconst(0.06666666666666667),	/* 1/15 */
+		_fixedpt_pconst(0.058823529411764705),	/* 1/17 */
+		_fixedpt_pconst(0.05263157894736842),	/* 1/19 */
+	};
+	_fixedpt_pd a;
+	_fixedpt_p m, s, r;
+	int b, e;
+
+	if (x <= 0) {
+		_FIXEDPT_CHECK(1, FIXEDPT_FN_LN, FIXEDPT_ERR_DOMAIN);
+		if (x < 0)
+			return (0);
+		return (fixedpt)0xffffffff;
+	}
+
+	/* x = m * 2^e, m in [1, 2) with _FIXEDPT_PBITS fraction bits */
+	b = _fixedpt_msb((fixedptu)x);
+	m = (_fixedpt_p)((_fixedpt_pu)x << (_FIXEDPT_PBITS - b));
+	e = b - FIXEDPT_FBITS;
+
+	/* ln(m / a) = 2 * atanh((m - a) / (m + a)), a = 2 above sqrt(2) */
+	a = (_fixedpt_pd)1 << _FIXEDPT_PBITS;
+	if (m > SQRT2) {
+		a <<= 1;
+		e++;
+	}
+	s = (_fixedpt_p)((((_fixedpt_pd)m - a) << _FIXEDPT_PBITS) / ((_fixedpt_pd)m + a));
+	r = _fixedpt_pmul(s, _fixedpt_poly(_fixedpt_pmul(s, s, _FIXEDPT_PBITS),
+	    LN_P, _FIXEDPT_LN_DEG, _FIXEDPT_PBITS, FIXEDPT_POLY_SCHEME),
+	    _FIXEDPT_PBITS);
+	return (_fixedpt_pround((_fixedpt_pd)e * LN2 + 2 * (_fixedpt_pd)r));
+}
+	
+
+/* Returns the logarithm of the given base of the given fixedpt number */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_log(fixedpt x, fixedpt base)
+{
+	return (fixedpt_div(fixedpt_ln(x), fixedpt_ln(base)));
+}
+
+
+/* Return the power value (n^exp) of the given fixedpt numbers */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_pow(fixedpt x, fixedpt exp)
+{
+	/* x^0 = 1, which saturates in Q1 */
+	if (exp == 0)
+		return (FIXEDPT_WBITS >= 2 ? FIXEDPT_ONE : FIXEDPT_MAX);
+	if (x < 0) {
+		_FIXEDPT_CHECK(1, FIXEDPT_FN_POW, FIXEDPT_ERR_DOMAIN);
+		return 0;
+	}
+	return (fixedpt_exp(fixedpt_mul(fixedpt_ln(x), exp)));
+}
+
+/* Taylor series of sin(pi/2 * t) / t in t^2, |t| <= 1 */
+static const _fixedpt_p _fixedpt_sin_c[11] = {
+	_fixedpt_pconst(1.5707963267948966),	/* (pi/2)^1 / 1! */
+	_fixedpt_pconst(-0.6459640975062462),	/* -(pi/2)^3 / 3! */
+	_fixedpt_pconst(0.07969262624616703),	/* (pi/2)^5 / 5! */
+	_fixedpt_pconst(-0.004681754135318687),	/* -(pi/2)^7 / 7! */
+	_fixedpt_pconst(0.00016044118478735975),	/* (pi/2)^9 / 9! */
+	_fixedpt_pconst(-3.598843235212084e-06),	/* -(pi/2)^11 / 11! */
+	_fixedpt_pconst(5.692172921967924e-08),	/* (pi/2)^13 / 13! */
+	_fixedpt_pconst(-6.688035109811464e-10),	/* -(pi/2)^15 / 15! */
+	_fixedpt_pconst(6.0669357311061955e-12),	/* (pi/2)^17 / 17! */
+	_fixedpt_pconst(-4.377065467313742e-14),	/* -(pi/2)^19 / 19! */
+	_fixedpt_pconst(2.571422892860474e-16),	/* (pi/2)^21 / 21! */
+};
+
+/* Taylor series of cos(pi/2 * t) in t^2, |t| <= 1 */
+static const _fixedpt_p _fixedpt_cos_c[12] = {
+	_fixedpt_pconst(1.0),	/* (pi/2)^0 / 0! */
+	_fixedpt_pconst(-1.2337005501361697),	/* -(pi/2)^2 / 2! */
+	_fixedpt_pconst(0.253669507901048),	/* (pi/2)^4 / 4! */
+	_fixedpt_pconst(-0.020863480763352957),	/* -(pi/2)^6 / 6! */
+	_fixedpt_pconst(0.0009192602748394263),	/* (pi/2)^8 / 8! */
+	_fixedpt_pconst(-2.5202042373060596e-05),	/* -(pi/2)^10 / 10! */
+	_fixedpt_pconst(4.710874778818169e-07),	/* (pi/2)^12 / 12! */
+	_fixedpt_pconst(-6.386603083791849e-09),	/* -(pi/2)^14 / 14! */
+	_fixedpt_pconst(6.565963114979473e-11),	/* (pi/2)^16 / 16! */
+	_fixedpt_pconst(-5.294400200734623e-13),	/* -(pi/2)^18 / 18! */
+	_fixedpt_pconst(3.437739179098607e-15),	/* (pi/2)^20 / 20! */
+	_fixedpt_pconst(-1.8359916521552453e-17),	/* -(pi/2)^22 / 22! */
+};
+
+/*
+ * Reduces the angle to [-pi/2, pi/2] and returns t = angle * 2/pi with
+ * _FIXEDPT_PBITS fraction bits. *flip is set if the cosine changes sign.
+ */
+_FIXEDPT_INLINE _fixedpt_p _fixedpt_trig_reduce(fixedpt angle, int *flip)
+{
+	static const _fixedpt_p TWO_BY_PI = _fixedpt_pconst(0.63661977236758134308);
+
+#if FIXEDPT_WBITS >= 4
+	/* Normalize to [-2pi, 2pi], then to [-pi, pi] */
+	angle %= FIXEDPT_TWO_PI;
+	if (angle < -FIXEDPT_PI)
+		angle = fixedpt_add(angle, FIXEDPT_TWO_PI);
+	else if (angle > FIXEDPT_PI)
+		angle = fixedpt_sub(angle, FIXEDPT_TWO_PI);
+
+	/* Reflect into [-pi/2, pi/2] */
+	*flip = 0;
+	if (angle > FIXEDPT_HALF_PI) {
+		angle = fixedpt_sub(FIXEDPT_PI, angle);
+		*flip = 1;
+	} else if (angle < -FIXEDPT_HALF_PI) {
+		angle = fixedpt_sub(-FIXEDPT_PI, angle);
+		*flip = 1;
+	}
+	return (_fixedpt_pmul(angle, TWO_BY_PI, FIXEDPT_FBITS));
+#else
+	/* 2pi does not fit, so reduce in fixedptd; |angle| < 4 is within a turn */
+	const fixedptd pi = (fixedptd)(3.14159265358979323846 *
+	    (double)((fixedptud)1 << FIXEDPT_FBITS) + 0.5);
+	const fixedptd half_pi = (fixedptd)(3.14159265358979323846 / 2 *
+	    (double)((fixedptud)1 << FIXEDPT_FBITS) + 0.5);
+	fixedptd a = angle;
+
+	if (a < -pi)
+		a += 2 * pi;
+	else if (a > pi)
+		a -= 2 * pi;
+	*flip = 0;
+	if (a > half_pi) {
+		a = pi - a;
+		*flip = 1;
+	} else if (a < -half_pi) {
+		a = -pi - a;
+		*flip = 1;
+	}
+	return (_fixedpt_pmul((_fixedpt_p)a, TWO_BY_PI, FIXEDPT_FBITS));
+#endif
+}
+
+/*
+ * Sets *s and *c to the sine and the unflipped cosine polynomial of the
+ * reduced angle t, with _FIXEDPT_PBITS fraction bits, sharing t^2.
+ */
+_FIXEDPT_INLINE void _fixedpt_sincos_p(_fixedpt_p t, _fixedpt_p *s, _fixedpt_p *c)
+{
+	_fixedpt_p t2 = _fixedpt_pmul(t, t, _FIXEDPT_PBITS);
+
+	*s = _fixedpt_pmul(t, _fixedpt_poly(t2, _fixedpt_sin_c, _FIXEDPT_SIN_DEG,
+	    _FIXEDPT_PBITS, FIXEDPT_POLY_SCHEME), _FIXEDPT_PBITS);
+	*c = _fixedpt_poly(t2, _fixedpt_cos_c, _FIXEDPT_COS_DEG,
+	    _FIXEDPT_PBITS, FIXEDPT_POLY_SCHEME);
+}
+
+/* Returns the sine of the given fixedpt number. */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_sin(fixedpt angle)
+{
+	int flip;
+	_fixedpt_p t = _fixedpt_trig_reduce(angle, &flip);
+
+	return (_fixedpt_pround(_fixedpt_pmul(t, _fixedpt_poly(
+	    _fixedpt_pmul(t, t, _FIXEDPT_PBITS), _fixedpt_sin_c, _FIXEDPT_SIN_DEG,
+	    _FIXEDPT_PBITS, FIXEDPT_POLY_SCHEME), _FIXEDPT_PBITS)));
+}
+
+/* Returns the cosine of the given fixedpt number */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_cos(fixedpt angle)
+{
+	int flip;
+	_fixedpt_p t = _fixedpt_trig_reduce(angle, &flip);
+	fixedpt val = _fixedpt_pround(_fixedpt_poly(_fixedpt_pmul(t, t, _FIXEDPT_PBITS),
+	    _fixedpt_cos_c, _FIXEDPT_COS_DEG, _FIXEDPT_PBITS, FIXEDPT_POLY_SCHEME));
+
+	return (flip ? -val : val);
+}
+
+/*
+ * Sets *s and *c to the sine and cosine of the angle, as fixedpt_sin()
+ * and fixedpt_cos() would, but with one reduction and one t^2.
+ */
+_FIXEDPT_FUNCTYPE void fixedpt_sincos(fixedpt angle, fixedpt *s, fixedpt *c)
+{
+	int flip;
+	_fixedpt_p sp, cp;
+
+	_fixedpt_sincos_p(_fixedpt_trig_reduce(angle, &flip), &sp, &cp);
+	*s = _fixedpt_pround(sp);
+	*c = flip ? -_fixedpt_pround(cp) : _fixedpt_pround(cp);
+}
+
+/* Returns the tangens of the given fixedpt number */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_tan(fixedpt angle)
+{
+	return fixedpt_div(fixedpt_sin(angle), fixedpt_cos(angle));
+}
+
+/*
+ * Returns atan(q) for 0 <= q <= 1, both with _FIXEDPT_PBITS fraction bits.
+ * The top bits of q index the nearest of 65 points c = i/64 directly, and
+ * a short Taylor expansion of atan around c covers d = q - c, |d| <= 1/128;
+ * there is no loop and no division.
+ */
+_FIXEDPT_INLINE _fixedpt_p _fixedpt_atan_unit(_fixedpt_p q)
+{
+	/* atan(c) and its Taylor coefficients f^(k)(c) / k!, k = 1..7 */
+	static const _fixedpt_p ATAN_T[65][8] = {
+		{ _fixedpt_pconst(0), _fixedpt_pconst(1),
+		  _fixedpt_pconst(-0), _fixedpt_pconst(-0.33333333333333331),
+		  _fixedpt_pconst(0), _fixedpt_pconst(0.20000000000000001),
+		  _fixedpt_pconst(0), _fixedpt_pconst(-0.14285714285714285) },	/* 0/64 */
+		{ _fixedpt_pconst(0.015623728620476831), _fixedpt_pconst(0.99975591896509641),
+		  _fixedpt_pconst(-0.015617373398527257), _fixedpt_pconst(-0.33284534997079263),
+		  _fixedpt_pconst(0.015605939545369761), _fixedpt_pconst(0.19926841197919795),
+		  _fixedpt_pconst(-0.015589435244407488), _fixedpt_pconst(-0.14188236657715644) },	/* 1/64 */
+		{ _fixedpt_pconst(0.031239833430268277), _fixedpt_pconst(0.99902439024390244),
+		  _fixedpt_pconst(-0.031189054134443783), _fixedpt_pconst(-0.33138496802619422),
+		  _fixedpt_pconst(0.031097828470334186), _fixedpt_pconst(0.19708362491474404),
+		  _fixedpt_pconst(-0.030966417136131207), _fixedpt_pconst(-0.13897938054121464) },	/* 2/64 */
+		{ _fixedpt_pconst(0.046840712915969654), _fixedpt_pconst(0.99780755176613889),
+		  _fixedpt_pconst(-0.046669683298196991), _fixedpt_pconst(-0.32896284330175313),
+		  _fixedpt_pconst(0.046363169370429315), _fixedpt_pconst(0.19347535153904813),
+		  _fixedpt_pconst(-0.045923136090949501), _fixedpt_pconst(-0.13421152928366653) },	/* 3/64 */
+		{ _fixedpt_pconst(0.06241880999595735), _fixedpt_pconst(0.99610894941634243),
+		  _fixedpt_pconst(-0.062014564944208088), _fixedpt_pconst(-0.32559657444118589),
+		  _fixedpt_pconst(0.061292537351934233), _fixedpt_pconst(0.18849239252123207),
+		  _fixedpt_pconst(-0.060260921564058226), _fixedpt_pconst(-0.12768213756913721) },	/* 4/64 */
+		{ _fixedpt_pconst(0.077966633831542301), _fixedpt_pconst(0.99393351128366902),
+		  _fixedpt_pconst(-0.077179986316615892), _fixedpt_pconst(-0.32131046507584243),
+		  _fixedpt_pconst(0.075781032568025652), _fixedpt_pconst(0.18220157978538248),
+		  _fixedpt_pconst(-0.073794446853828202), _fixedpt_pconst(-0.11953123992394124) },	/* 5/64 */
+		{ _fixedpt_pconst(0.09347678115858947), _fixedpt_pconst(0.99128751210067767),
+		  _fixedpt_pconst(-0.092123524841882923), _fixedpt_pconst(-0.31613519808061014),
+		  _fixedpt_pconst(0.089729635278462644), _fixedpt_pconst(0.17468634435813651),
+		  _fixedpt_pconst(-0.086355514147207824), _fixedpt_pconst(-0.10993120326594877) },	/* 6/64 */
+		{ _fixedpt_pconst(0.10894195698986579), _fixedpt_pconst(0.98817852834740649),
+		  _fixedpt_pconst(-0.1068043379251238), _fixedpt_pconst(-0.31010742891428672),
+		  _fixedpt_pconst(0.10304643577830017), _fixedpt_pconst(0.16604495347017262),
+		  _fixedpt_pconst(-0.097796308618337088), _fixedpt_pconst(-0.099081430016782865) },	/* 7/64 */
+		{ _fixedpt_pconst(0.12435499454676144), _fixedpt_pconst(0.98461538461538467),
+		  _fixedpt_pconst(-0.12118343195266272), _fixedpt_pconst(-0.30326930663025337),
+		  _fixedpt_pconst(0.11564771541612688), _fixedpt_pconst(0.15638847103500469),
+		  _fixedpt_pconst(-0.10799203289571502), _fixedpt_pconst(-0.08720236389717112) },	/* 8/64 */
+		{ _fixedpt_pconst(0.13970887428916365), _fixedpt_pconst(0.9806080919320086),
+		  _fixedpt_pconst(-0.13522390733848144), _fixedpt_pconst(-0.29566793249107381),
+		  _fixedpt_pconst(0.12745885944493601), _fixedpt_pconst(0.14583850275930332),
+		  _fixedpt_pconst(-0.11684285887157525), _fixedpt_pconst(-0.074529043263798486) },	/* 9/64 */
+		{ _fixedpt_pconst(0.15499674192394097), _fixedpt_pconst(0.97616777883698758),
+		  _fixedpt_pconst(-0.14889117694367782), _fixedpt_pconst(-0.28735476717035957),
+		  _fixedpt_pconst(0.13841508743188688), _fixedpt_pconst(0.13452479177016766),
+		  _fixedpt_pconst(-0.1242751612572731), _fixedpt_pconst(-0.061304456523123253) },	/* 10/64 */
+		{ _fixedpt_pconst(0.17021192528547441), _fixedpt_pconst(0.97130661607778046),
+		  _fixedpt_pconst(-0.16215315573126807), _fixedpt_pconst(-0.2783849982543149),
+		  _fixedpt_pconst(0.14846199219686829), _fixedpt_pconst(0.12258273267708131),
+		  _fixedpt_pconst(-0.13024202506521784), _fixedpt_pconst(-0.047772950895208666) },	/* 11/64 */
+		{ _fixedpt_pconst(0.18534794999569476), _fixedpt_pconst(0.96603773584905661),
+		  _fixedpt_pconst(-0.17498042007831968), _fixedpt_pconst(-0.26881688015386301),
+		  _fixedpt_pconst(0.15755588355133229), _fixedpt_pconst(0.11015087145241903),
+		  _fixedpt_pconst(-0.13472304594573925), _fixedpt_pconst(-0.034173930455175493) },	/* 12/64 */
+		{ _fixedpt_pconst(0.20039855382587851), _fixedpt_pconst(0.96037514654161782),
+		  _fixedpt_pconst(-0.18734633573801313), _fixedpt_pconst(-0.2587110586087033),
+		  _fixedpt_pconst(0.16566393827317999), _fixedpt_pconst(0.097368455570338117),
+		  _fixedpt_pconst(-0.13772346678440775), _fixedpt_pconst(-0.020736053515491466) },	/* 13/64 */
+		{ _fixedpt_pconst(0.21535769969773805), _fixedpt_pconst(0.95433364398881637),
+		  _fixedpt_pconst(-0.19922715401071284), _fixedpt_pconst(-0.24812989172132627),
+		  _fixedpt_pconst(0.1727641626019111), _fixedpt_pconst(0.084373093753082884),
+		  _fixedpt_pconst(-0.1392727151327017), _fixedpt_pconst(-0.007672105144332606) },	/* 14/64 */
+		{ _fixedpt_pconst(0.23021958727684372), _fixedpt_pconst(0.94792872020365659),
+		  _fixedpt_pconst(-0.21060207623131458), _fixedpt_pconst(-0.2371367789266319),
+		  _fixedpt_pconst(0.17884517791624213), _fixedpt_pconst(0.071298577785406769),
+		  _fixedpt_pconst(-0.13942242311654771), _fixedpt_pconst(0.00482531957739607) },	/* 15/64 */
+		{ _fixedpt_pconst(0.24497866312686414), _fixedpt_pconst(0.94117647058823528),
+		  _fixedpt_pconst(-0.22145328719723184), _fixedpt_pconst(-0.22579550851482461),
+		  _fixedpt_pconst(0.18390584403922366), _fixedpt_pconst(0.058272910581840281),
+		  _fixedpt_pconst(-0.1382440239390581), _fixedpt_pconst(0.016587229433004756) },	/* 16/64 */
+		{ _fixedpt_pconst(0.25962962940825751), _fixedpt_pconst(0.93409350057012541),
+		  _fixedpt_pconst(-0.2317659586363276), _fixedpt_pconst(-0.21416963332192596),
+		  _fixedpt_pconst(0.18795473771233343), _fixedpt_pconst(0.045416575471456153),
+		  _fixedpt_pconst(-0.13582602675060107), _fixedpt_pconst(0.027470700101007505) },	/* 17/64 */
+		{ _fixedpt_pconst(0.27416745111965879), _fixedpt_pconst(0.92669683257918556),
+		  _fixedpt_pconst(-0.24152822423783296), _fixedpt_pconst(-0.20232188302838686),
+		  _fixedpt_pconst(0.19100950613396706), _fixedpt_pconst(0.032841071951229733),
+		  _fixedpt_pconst(-0.13227107456173012), _fixedpt_pconst(0.037360380775054047) },	/* 18/64 */
+		{ _fixedpt_pconst(0.28858736189407741), _fixedpt_pconst(0.91900381422481492),
+		  _fixedpt_pconst(-0.25073112813492821), _fixedpt_pconst(-0.19031362020915049),
+		  _fixedpt_pconst(0.19309611704775037), _fixedpt_pconst(0.020647733385215417),
+		  _fixedpt_pconst(-0.12769288832826869), _fixedpt_pconst(0.046169077430587041) },	/* 19/64 */
+		{ _fixedpt_pconst(0.30288486837497142), _fixedpt_pconst(0.91103202846975084),
+		  _fixedpt_pconst(-0.25936854903053408), _fixedpt_pconst(-0.17820434590567655),
+		  _fixedpt_pconst(0.19424802770316565), _fixedpt_pconst(0.00892683268721251),
+		  _fixedpt_pconst(-0.12221319485042208), _fixedpt_pconst(0.053837479012086013) },	/* 20/64 */
+		{ _fixedpt_pconst(0.31705575320914703), _fixedpt_pconst(0.90279920652413492),
+		  _fixedpt_pconst(-0.26743710239551188), _fixedpt_pconst(-0.1660512590878396),
+		  _fixedpt_pconst(0.19450529513491138), _fixedpt_pconst(-0.0022430267409827695),
+		  _fixedpt_pconst(-0.11595872735624052), _fixedpt_pconst(0.060333119508069341) },	/* 21/64 */
+		{ _fixedpt_pconst(0.3310960767041321), _fixedpt_pconst(0.89432314410480351),
+		  _fixedpt_pconst(-0.27493602334051603), _fixedpt_pconst(-0.15390887298395117),
+		  _fixedpt_pconst(0.19391364968198288), _fixedpt_pconst(-0.012795245362055171),
+		  _fixedpt_pconst(-0.10905837633522092), _fixedpt_pconst(0.065648688445875944) },	/* 22/64 */
+		{ _fixedpt_pconst(0.34500217720710513), _fixedpt_pconst(0.88562162162162161),
+		  _fixedpt_pconst(-0.28186703287070852), _fixedpt_pconst(-0.14182868991851749),
+		  _fixedpt_pconst(0.1925235525749833), _fixedpt_pconst(-0.022675304363427472),
+		  _fixedpt_pconst(-0.10164055514086032), _fixedpt_pconst(0.069799814652390768) },	/* 23/64 */
+		{ _fixedpt_pconst(0.35877067027057225), _fixedpt_pconst(0.87671232876712324),
+		  _fixedpt_pconst(-0.28823419027960218), _fixedpt_pconst(-0.12985893504225607),
+		  _fixedpt_pconst(0.19038925685573271), _fixedpt_pconst(-0.031840607638869901),
+		  _fixedpt_pconst(-0.093830830871549767), _fixedpt_pconst(0.072822453494020944) },	/* 24/64 */
+		{ _fixedpt_pconst(0.3723984466767542), _fixedpt_pconst(0.86761279389959756),
+		  _fixedpt_pconst(-0.29404373442901), _fixedpt_pconst(-0.11804434819367986),
+		  _fixedpt_pconst(0.18756788895900106), _fixedpt_pconst(-0.040260115571754955),
+		  _fixedpt_pconst(-0.085749856794330101), _fixedpt_pconst(0.074770006879918888) },	/* 25/64 */
+		{ _fixedpt_pconst(0.38588266939807375), _fixedpt_pconst(0.85834031852472759),
+		  _fixedpt_pconst(-0.29930391660208439), _fixedpt_pconst(-0.10642603211608065),
+		  _fixedpt_pconst(0.18411856608608679), _fixedpt_pconst(-0.04791380004591736),
+		  _fixedpt_pconst(-0.077511628736741445), _fixedpt_pconst(0.075710298992804473) },	/* 26/64 */
+		{ _fixedpt_pconst(0.39922076957525254), _fixedpt_pconst(0.8489119170984456),
+		  _fixedpt_pconst(-0.30402482751214799), _fixedpt_pconst(-0.095041354381434628),
+		  _fixedpt_pconst(0.18010156213503786), _fixedpt_pconst(-0.054791951598578012),
+		  _fixedpt_pconst(-0.069222074970536521), _fixedpt_pconst(0.075722520068924437) },	/* 27/64 */
+		{ _fixedpt_pconst(0.41241044159738732), _fixedpt_pconst(0.83934426229508197),
+		  _fixedpt_pconst(-0.30821822090835799), _fixedpt_pconst(-0.083923899650925254),
+		  _fixedpt_pconst(0.17557753251680414), _fixedpt_pconst(-0.06089436996927601),
+		  _fixedpt_pconst(-0.06097797755826137), _fixedpt_pconst(0.074894236720832119) },	/* 28/64 */
+		{ _fixedpt_pconst(0.42544963737004227), _fixedpt_pconst(0.82965363581122142),
+		  _fixedpt_pconst(-0.31189733604732162), _fixedpt_pconst(-0.073103468332148203),
+		  _fixedpt_pconst(0.17060680576496157), _fixedpt_pconst(-0.066229468630047084),
+		  _fixedpt_pconst(-0.052866213215834734), _fixedpt_pconst(0.073318551413132191) },	/* 29/64 */
+		{ _fixedpt_pconst(0.43833655985795783), _fixedpt_pconst(0.81985588470776616),
+		  _fixedpt_pconst(-0.31507672110466595), _fixedpt_pconst(-0.062606117272429665),
+		  _fixedpt_pconst(0.16524874751139979), _fixedpt_pconst(-0.070813322367153125),
+		  _fixedpt_pconst(-0.044963293627483122), _fixedpt_pconst(0.071091476817354088) },	/* 30/64 */
+		{ _fixedpt_pconst(0.4510696559885235), _fixedpt_pconst(0.80996638323116477),
+		  _fixedpt_pconst(-0.31777205938909053), _fixedpt_pconst(-0.052454237848726402),
+		  _fixedpt_pconst(0.15956120021092884), _fixedpt_pconst(-0.07466868479583598),
+		  _fixedpt_pconst(-0.037335178890859945), _fixedpt_pconst(0.068309573819947303) },	/* 31/64 */
+		{ _fixedpt_pconst(0.46364760900080609), _fixedpt_pconst(0.80000000000000004),
+		  _fixedpt_pconst(-0.32000000000000001), _fixedpt_pconst(-0.042666666666666665),
+		  _fixedpt_pconst(0.15359999999999999), _fixedpt_pconst(-0.077824000000000004),
+		  _fixedpt_pconst(-0.030037333333333333), _fixedpt_pconst(0.06506788571428572) },	/* 32/64 */
+		{ _fixedpt_pconst(0.47606933032276122), _fixedpt_pconst(0.78997107039537129),
+		  _fixedpt_pconst(-0.32177799434426696), _fixedpt_pconst(-0.033258824051370851),
+		  _fixedpt_pconst(0.14741857030121533), _fixedpt_pconst(-0.080312429464458615),
+		  _fixedpt_pconst(-0.023114990212978026), _fixedpt_pconst(0.061458186179634312) },	/* 33/64 */
+		{ _fixedpt_pconst(0.48833395105640554), _fixedpt_pconst(0.77989337395277991),
+		  _fixedpt_pconst(-0.32312413970320814), _fixedpt_pconst(-0.024242875586053755),
+		  _fixedpt_pconst(0.14106759025610238), _fixedpt_pconst(-0.08217091226111202),
+		  _fixedpt_pconst(-0.01660359063068621), _fixedpt_pconst(0.057567545469917651) },	/* 34/64 */
+		{ _fixedpt_pconst(0.50044081314729416), _fixedpt_pconst(0.76978011651945122),
+		  _fixedpt_pconst(-0.32405703082194526), _fixedpt_pconst(-0.015627912115457162),
+		  _fixedpt_pconst(0.13459473479257281), _fixedpt_pconst(-0.083439273197074504),
+		  _fixedpt_pconst(-0.010529362125760949), _fixedpt_pconst(0.053477208070892693) },	/* 35/64 */
+		{ _fixedpt_pconst(0.51238946031073773), _fixedpt_pconst(0.75964391691394662),
+		  _fixedpt_pconst(-0.3245956202837042), _fixedpt_pconst(-0.0074201438640521455),
+		  _fixedpt_pconst(0.12804448210964214), _fixedpt_pconst(-0.08415939044671554),
+		  _fixedpt_pconst(-0.0049100036780431074), _fixedpt_pconst(0.04926176605657244) },	/* 36/64 */
+		{ _fixedpt_pconst(0.52417962878291324), _fixedpt_pconst(0.74949679780420864),
+		  _fixedpt_pconst(-0.32475908823428473), _fixedpt_pconst(0.00037689539183326562),
+		  _fixedpt_pconst(0.12145798358134004), _fixedpt_pconst(-0.084374431163394437),
+		  _fixedpt_pconst(0.00024455403941765666), _fixedpt_pconst(0.044988605480126148) },	/* 37/64 */
+		{ _fixedpt_pconst(0.5358112379604637), _fixedpt_pconst(0.73935018050541512),
+		  _fixedpt_pconst(-0.32456672183920032), _fixedpt_pconst(0.0077621378280120362),
+		  _fixedpt_pconst(0.11487299052889789), _fixedpt_pconst(-0.08412816077114979),
+		  _fixedpt_pconst(0.0049313415502075788), _fixedpt_pconst(0.040717598266938881) },	/* 38/64 */
+		{ _fixedpt_pconst(0.54728438098743692), _fixedpt_pconst(0.72921488338970986),
+		  _fixedpt_pconst(-0.32403780468946336), _fixedpt_pconst(0.014736768123871034),
+		  _fixedpt_pconst(0.10832383196515005), _fixedpt_pconst(-0.083464329121817463),
+		  _fixedpt_pconst(0.0091535218077130574), _fixedpt_pconst(0.036501009060001526) },	/* 39/64 */
+		{ _fixedpt_pconst(0.55859931534356244), _fixedpt_pconst(0.7191011235955056),
+		  _fixedpt_pconst(-0.32319151622269915), _fixedpt_pconst(0.021304010058125489),
+		  _fixedpt_pconst(0.10184143725436903), _fixedpt_pconst(-0.082426134500130754),
+		  _fixedpt_pconst(0.012919561541074584), _fixedpt_pconst(0.032383585072754476) },	/* 40/64 */
+		{ _fixedpt_pconst(0.56975645348297843), _fixedpt_pconst(0.7090185217240782),
+		  _fixedpt_pconst(-0.32204684109468257), _fixedpt_pconst(0.027468915766428018),
+		  _fixedpt_pconst(0.095453397629435568), _fixedpt_pconst(-0.081055764582827733),
+		  _fixedpt_pconst(0.01624242097665245), _fixedpt_pconst(0.02840279697676697) },	/* 41/64 */
+		{ _fixedpt_pconst(0.58075635356767041), _fixedpt_pconst(0.69897610921501707),
+		  _fixedpt_pconst(-0.32062248832251977), _fixedpt_pconst(0.033238159903243615),
+		  _fixedpt_pconst(0.089184060640723928), _fixedpt_pconst(-0.079394011908163309),
+		  _fixedpt_pconst(0.019138776750677156), _fixedpt_pconst(0.02458919992709269) },	/* 42/64 */
+		{ _fixedpt_pconst(0.59159971033511138), _fixedpt_pconst(0.68898233809924303),
+		  _fixedpt_pconst(-0.31893681992415762), _fixedpt_pconst(0.038619840587083107),
+		  _fixedpt_pconst(0.083054651852177572), _fixedpt_pconst(-0.077479960178691965),
+		  _fixedpt_pconst(0.021628289547842041), _fixedpt_pconst(0.020966885748688598) },	/* 43/64 */
+		{ _fixedpt_pconst(0.60228734613496415), _fixedpt_pconst(0.67904509283819625),
+		  _fixedpt_pconst(-0.31700778869899882), _fixedpt_pconst(0.043623288662702833),
+		  _fixedpt_pconst(0.077083418425777983), _fixedpt_pconst(-0.07535073678326322),
+		  _fixedpt_pconst(0.023732924964874721), _fixedpt_pconst(0.017553999832043015) },	/* 44/64 */
+		{ _fixedpt_pconst(0.61282020216524136), _fixedpt_pconst(0.66917170396993952),
+		  _fixedpt_pconst(-0.31485288473017903), _fixedpt_pconst(0.04825888649081251),
+		  _fixedpt_pconst(0.071285789623770079), _fixedpt_pconst(-0.073041326258152808),
+		  _fixedpt_pconst(0.025476333361622611), _fixedpt_pconst(0.014363299199227299) },	/* 45/64 */
+		{ _fixedpt_pconst(0.6231993299340659), _fixedpt_pconst(0.6593689632968448),
+		  _fixedpt_pconst(-0.3124890901393933), _fixedpt_pconst(0.052537897178451337),
+		  _fixedpt_pconst(0.065674549688576361), _fixedpt_pconst(-0.070584438982426292),
+		  _fixedpt_pconst(0.026883292056905848), _fixedpt_pconst(0.011402731316661774) },	/* 46/64 */
+		{ _fixedpt_pconst(0.63342588296914459), _fixedpt_pconst(0.64964314036478987),
+		  _fixedpt_pconst(-0.30993284158878476), _fixedpt_pconst(0.056472304893580696),
+		  _fixedpt_pconst(0.060260019015701043), _fixedpt_pconst(-0.068010429187189511),
+		  _fixedpt_pconst(0.027979211165673135), _fixedpt_pconst(0.0086760163932820596) },	/* 47/64 */
+		{ _fixedpt_pconst(0.64350110879328437), _fixedpt_pconst(0.64000000000000001),
+		  _fixedpt_pconst(-0.30719999999999997), _fixedpt_pconst(0.060074666666666665),
+		  _fixedpt_pconst(0.05505024), _fixedpt_pconst(-0.065347256320000005),
+		  _fixedpt_pconst(0.028789702656000001), _fixedpt_pconst(0.0061832189893485717) },	/* 48/64 */
+		{ _fixedpt_pconst(0.65342634118076193), _fixedpt_pconst(0.63044482068647067),
+		  _fixedpt_pconst(-0.30430582694670955), _fixedpt_pconst(0.063357975870285813),
+		  _fixedpt_pconst(0.050051164397881591), _fixedpt_pconst(-0.062620483912825167),
+		  _fixedpt_pconst(0.029340210815538073), _fixedpt_pconst(0.0039212976785841947) },	/* 49/64 */
+		{ _fixedpt_pconst(0.66320299270609329), _fixedpt_pconst(0.62098241358399031),
+		  _fixedpt_pconst(-0.30126496717234219), _fixedpt_pconst(0.066335537384574261),
+		  _fixedpt_pconst(0.045266839497119515), _fixedpt_pconst(-0.059853310324678839),
+		  _fixedpt_pconst(0.029655701234811923), _fixedpt_pconst(0.0018846241885264814) },	/* 50/64 */
+		{ _fixedpt_pconst(0.67283254759376321), _fixedpt_pconst(0.61161714200388229),
+		  _fixedpt_pconst(-0.29809143668816962), _fixedpt_pconst(0.069020854300574405),
+		  _fixedpt_pconst(0.04069959081405989), _fixedpt_pconst(-0.05706662604097925),
+		  _fixedpt_pconst(0.029760404611019996), _fixedpt_pconst(6.5465848563830243e-05) },	/* 51/64 */
+		{ _fixedpt_pconst(0.68231655487474807), _fixedpt_pconst(0.60235294117647054),
+		  _fixedpt_pconst(-0.294798615916955), _fixedpt_pconst(0.071427525883709889),
+		  _fixedpt_pconst(0.036350199439182961), _fixedpt_pconst(-0.05427909258611277),
+		  _fixedpt_pconst(0.029677611118976946), _fixedpt_pconst(-0.0015455727202494489) },	/* 52/64 */
+		{ _fixedpt_pconst(0.69165662185319987), _fixedpt_pconst(0.59319333816075304),
+		  _fixedpt_pconst(-0.29139924736296519), _fixedpt_pconst(0.073569156413915843),
+		  _fixedpt_pconst(0.032218072522135967), _fixedpt_pconst(-0.051507238522081951),
+		  _fixedpt_pconst(0.029429510752265128), _fixedpt_pconst(-0.0029591509408908932) },	/* 53/64 */
+		{ _fixedpt_pconst(0.70085440788445019), _fixedpt_pconst(0.58414147176269249),
+		  _fixedpt_pconst(-0.28790543730916507), _fixedpt_pconst(0.0754592744353446),
+		  _fixedpt_pconst(0.028301405723950884), _fixedpt_pconst(-0.048765568446015643),
+		  _fixedpt_pconst(0.029037074874336599), _fixedpt_pconst(-0.0041868374096260914) },	/* 54/64 */
+		{ _fixedpt_pconst(0.70991161846352491), _fixedpt_pconst(0.575200112343772),
+		  _fixedpt_pconst(-0.2843286610658724), _fixedpt_pconst(0.077111261884912852),
+		  _fixedpt_pconst(0.024597336765983257), _fixedpt_pconst(-0.046066681347335985),
+		  _fixedpt_pconst(0.028519974204286778), _fixedpt_pconst(-0.005240798370927691) },	/* 55/64 */
+		{ _fixedpt_pconst(0.71882999962162453), _fixedpt_pconst(0.5663716814159292),
+		  _fixedpt_pconst(-0.28067977132116845), _fixedpt_pconst(0.078538292523074524),
+		  _fixedpt_pconst(0.021102089472027703), _fixedpt_pconst(-0.043421395129024279),
+		  _fixedpt_pconst(0.027896528565508123), _fixedpt_pconst(-0.00613352813493513) },	/* 56/64 */
+		{ _fixedpt_pconst(0.72761133262651068), _fixedpt_pconst(0.55765827093260723),
+		  _fixedpt_pconst(-0.27696900917115741), _fixedpt_pconst(0.079753279059930543),
+		  _fixedpt_pconst(0.017811107932823741), _fixedpt_pconst(-0.040838874526887808),
+		  _fixedpt_pconst(0.02718368392034225), _fixedpt_pconst(-0.0068776193131623083) },	/* 57/64 */
+		{ _fixedpt_pconst(0.7362574289814281), _fixedpt_pconst(0.54906166219839148),
+		  _fixedpt_pconst(-0.2732060174370548), _fixedpt_pconst(0.080768828353028538),
+		  _fixedpt_pconst(0.014719180622174982), _fixedpt_pconst(-0.038326760068582384),
+		  _fixedpt_pconst(0.026397012476140822), _fixedpt_pconst(-0.0074855702323372185) },	/* 58/64 */
+		{ _fixedpt_pconst(0.74477012571607515), _fixedpt_pconst(0.54058334433152966),
+		  _fixedpt_pconst(-0.26939985590548449), _fixedpt_pconst(0.081597204047973784),
+		  _fixedpt_pconst(0.011820554463073601), _fixedpt_pconst(-0.035891296095077976),
+		  _fixedpt_pconst(0.025550731956956285), _fixedpt_pconst(-0.0079696265466242984) },	/* 59/64 */
+		{ _fixedpt_pconst(0.75315128096219441), _fixedpt_pconst(0.53222453222453225),
+		  _fixedpt_pconst(-0.26555901815777078), _fixedpt_pconst(0.082250296037407952),
+		  _fixedpt_pconst(0.0091090389828020653), _fixedpt_pconst(-0.033537456217758534),
+		  _fixedpt_pconst(0.024657740472706573), _fixedpt_pconst(-0.0083416538766450856) },	/* 60/64 */
+		{ _fixedpt_pconst(0.76140276980557842), _fixedpt_pconst(0.5239861839580402),
+		  _fixedpt_pconst(-0.26169144968302277), _fixedpt_pconst(0.082739596126303813),
+		  _fixedpt_pconst(0.0065781008104382069), _fixedpt_pconst(-0.031269064902433856),
+		  _fixedpt_pconst(0.023729663769408518), _fixedpt_pconst(-0.0086130382329246656) },	/* 61/64 */
+		{ _fixedpt_pconst(0.7695264804056583), _fixedpt_pconst(0.5158690176322418),
+		  _fixedpt_pconst(-0.25780456699807752), _fixedpt_pconst(0.083076179310320061),
+		  _fixedpt_pconst(0.0042209488610878759), _fixedpt_pconst(-0.029088914156463135),
+		  _fixedpt_pconst(0.022776911998077107), _fixedpt_pconst(-0.0087946110071262067) },	/* 62/64 */
+		{ _fixedpt_pconst(0.77752431037334779), _fixedpt_pconst(0.5078735275883447),
+		  _fixedpt_pconst(-0.25390527752463804), _fixedpt_pconst(0.083270690097768232),
+		  _fixedpt_pconst(0.0020306106210981299), _fixedpt_pconst(-0.026998874547191999),
+		  _fixedpt_pconst(0.021808743486809459), _fixedpt_pconst(-0.0088965954147426553) },	/* 63/64 */
+		{ _fixedpt_pconst(0.78539816339744828), _fixedpt_pconst(0.5),
+		  _fixedpt_pconst(-0.25), _fixedpt_pconst(0.083333333333333329),
+		  _fixedpt_pconst(0), _fixedpt_pconst(-0.025000000000000001),
+		  _fixedpt_pconst(0.020833333333333332), _fixedpt_pconst(-0.0089285714285714281) },	/* 64/64 */
+	};
+	const int shift = _FIXEDPT_PBITS - 6;
+	int i = (int)((q + ((_fixedpt_p)1 << (shift - 1))) >> shift);
+
+	return (_fixedpt_poly(q - ((_fixedpt_p)i << shift), ATAN_T[i],
+	    _FIXEDPT_ATAN_DEG, _FIXEDPT_PBITS, FIXEDPT_POLY_SCHEME));
+}
+
+/*
+ * Returns atan2(y, x) with _FIXEDPT_PBITS fraction bits, in a fixedptd as
+ * it can exceed 2. The octant is reduced by dividing the smaller of |x|
+ * and |y| by the larger, which is the only division; the symmetries then
+ * map the result back.
+ */
+_FIXEDPT_INLINE _fixedpt_pd _fixedpt_atan2_p(fixedpt y, fixedpt x)
+{
+	static const _fixedpt_p QUARTER_PI = _fixedpt_pconst(0.78539816339744830962);
+	fixedptu ax = (x < 0) ? -(fixedptu)x : (fixedptu)x;
+	fixedptu ay = (y < 0) ? -(fixedptu)y : (fixedptu)y;
+	fixedptu lo = (ax < ay) ? ax : ay;
+	fixedptu hi = (ax < ay) ? ay : ax;
+	_fixedpt_pd theta;
+
+	/* Origin (undefined, return 0) */
+	if (hi == 0)
+		return (0);
+	theta = _fixedpt_atan_unit((_fixedpt_p)(((_fixedpt_pud)lo << _FIXEDPT_PBITS) / hi));
+	if (ay > ax)
+		theta = 2 * (_fixedpt_pd)QUARTER_PI - theta;
+	if (x < 0)
+		theta = 4 * (_fixedpt_pd)QUARTER_PI - theta;
+	return ((y < 0) ? -theta : theta);
+}
+
+_FIXEDPT_INLINE fixedpt _fixedpt_atan(fixedpt z)
+{
+	static const _fixedpt_p QUARTER_PI = _fixedpt_pconst(0.78539816339744830962);
+	fixedptu az = (z < 0) ? -(fixedptu)z : (fixedptu)z;
+	_fixedpt_pd theta;
+
+	/* Use arctan(z) = pi/2 - arctan(1/z) for z > 1 */
+	if ((fixedptud)az <= (fixedptud)1 << FIXEDPT_FBITS)
+		theta = _fixedpt_atan_unit((_fixedpt_p)((_fixedpt_pd)az <<
+		    (_FIXEDPT_PBITS - FIXEDPT_FBITS)));
+	else
+		theta = 2 * (_fixedpt_pd)QUARTER_PI - _fixedpt_atan_unit((_fixedpt_p)
+		    (((_fixedpt_pud)1 << (FIXEDPT_FBITS + _FIXEDPT_PBITS)) / az));
+	return (_fixedpt_pround((z < 0) ? -theta : theta));
+}
+
+/* Returns the arctangent of the given fixedpt number */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_atan(fixedpt z)
+{
+	return (_fixedpt_atan(z));
+}
+
+/* Returns the angle of the point (x, y), in [-pi, pi] */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_atan2(fixedpt y, fixedpt x)
+{
+	return (_fixedpt_pround(_fixedpt_atan2_p(y, x)));
+}
+
+/*
+ * Returns sqrt(1 - x^2) for -1 < x <= 1, rounded to nearest. 1 - x^2 is
+ * taken exactly as (1 - x) * (1 + x) with twice FIXEDPT_FBITS fraction bits,
+ * one being a fixedptd since Q1 cannot hold it, and sqrt(1) saturates there.
+ */
+_FIXEDPT_INLINE fixedpt _fixedpt_sqrt_1mx2(fixedpt x)
+{
+	const fixedptd one = (fixedptd)1 << FIXEDPT_FBITS;
+	fixedptud r = _fixedpt_isqrt((fixedptud)((one - x) * (one + x)));
+
+	return ((r > (fixedptud)FIXEDPT_MAX) ? FIXEDPT_MAX : (fixedpt)r);
+}
+
+/* Returns the arcsin of the given fixedpt number */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_asin(fixedpt x)
+{
+#if FIXEDPT_WBITS >= 2
+	/* Ensure input is within valid range (-1 to 1) */
+	if (x > FIXEDPT_ONE || x < -FIXEDPT_ONE) 
+	{
+		_FIXEDPT_CHECK(1, FIXEDPT_FN_ASIN, FIXEDPT_ERR_DOMAIN);
+		return x;
+	}
+
+	/* Handle special cases (x = ±1) */
+	if (x == FIXEDPT_ONE) 
+	{
+		return FIXEDPT_HALF_PI;
+	} 
+	else if (x == -FIXEDPT_ONE) 
+	{
+		return -FIXEDPT_HALF_PI;
+	}
+#else
+	/* Every Q1 number is in range, and asin(-1) = -pi/2 saturates */
+	if (x == FIXEDPT_MIN)
+	{
+		return FIXEDPT_MIN;
+	}
+#endif
+
+	return fixedpt_atan2(x, _fixedpt_sqrt_1mx2(x));
+}
+
+/* Returns the arccos of the given fixedpt number */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_acos(fixedpt x)
+{
+#if FIXEDPT_WBITS >= 2
+	/* Ensure input is within valid range (-1 to 1) */
+	if (x > FIXEDPT_ONE || x < -FIXEDPT_ONE) 
+	{
+		_FIXEDPT_CHECK(1, FIXEDPT_FN_ACOS, FIXEDPT_ERR_DOMAIN);
+		return x;
+	}
+#else
+	/* Every Q1 number is in range, and acos(-1) = pi saturates */
+	if (x == FIXEDPT_MIN)
+	{
+		return FIXEDPT_MAX;
+	}
+#endif
+
+#if FIXEDPT_WBITS >= 3
+	/* Handle special cases (x = ±1); pi needs 3 whole bits */
+	if (x == FIXEDPT_ONE) 
+	{
+		return 0;
+	} 
+	else if (x == -FIXEDPT_ONE) 
+	{
+		return FIXEDPT_PI;
+	}
+#endif
+
+	return fixedpt_atan2(_fixedpt_sqrt_1mx2(x), x);
+}
+
+/*
+ * Complex numbers.
+ *
+ * Products are formed exactly in fixedptd and each component is rounded
+ * once, like fixedpt_mul(). The Gauss form with three multiplies trades a
+ * multiply for three additions, but its sums need one bit more than a
+ * fixedpt, so its products no longer fit a single widening multiply and
+ * it ends up slower at every width, scalar or vectorized. The magnitude
+ * is the integer square root of the exact sum of squares, which has
+ * FIXEDPT_FBITS fraction bits as it stands.
+ */
+
+/* Rounds an exact product to fixedpt, as fixedpt_mul() does */
+_FIXEDPT_INLINE fixedpt _fixedpt_dround(fixedptd p)
+{
+	return ((fixedpt)(((p >> (FIXEDPT_FBITS - 1)) + 1) >> 1));
+}
+
+_FIXEDPT_INLINE fixedpt_complex _fixedpt_cmul(fixedpt ar, fixedpt ai, fixedpt br, fixedpt bi)
+{
+	fixedpt_complex r;
+
+	/* The sums can only wrap where the rounded result would anyway */
+	r.re = _fixedpt_dround((fixedptd)((fixedptud)((fixedptd)ar * br) -
+	    (fixedptud)((fixedptd)ai * bi)));
+	r.im = _fixedpt_dround((fixedptd)((fixedptud)((fixedptd)ar * bi) +
+	    (fixedptud)((fixedptd)ai * br)));
+	return (r);
+}
+
+/* Returns |re + i * im|, saturating at FIXEDPT_MAX */
+_FIXEDPT_INLINE fixedpt _fixedpt_cabs(fixedpt re, fixedpt im)
+{
+	fixedptud s = (fixedptud)((fixedptd)re * re) + (fixedptud)((fixedptd)im * im);
+	fixedptud r = _fixedpt_isqrt(s & (((fixedptud)1 << (2 * FIXEDPT_BITS - 2)) - 1));
+
+	/* s >= 2^(2 * FIXEDPT_BITS - 2) has a root of at least 2^(FIXEDPT_BITS - 1) */
+	return ((s >> (2 * FIXEDPT_BITS - 2) != 0 || r > (fixedptud)FIXEDPT_MAX) ?
+	    FIXEDPT_MAX : (fixedpt)r);
+}
+
+/* Returns the product of two complex numbers, rounding each component once */
+_FIXEDPT_FUNCTYPE fixedpt_complex fixedpt_cmul(fixedpt_complex a, fixedpt_complex b)
+{
+	return (_fixedpt_cmul(a.re, a.im, b.re, b.im));
+}
+
+/* Returns the complex conjugate */
+_FIXEDPT_FUNCTYPE fixedpt_complex fixedpt_conj(fixedpt_complex a)
+{
+	a.im = -a.im;
+	return (a);
+}
+
+/* Returns |a|^2, rounded once and saturating at FIXEDPT_MAX */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_cabs2(fixedpt_complex a)
+{
+	fixedptud s = (fixedptud)((fixedptd)a.re * a.re) + (fixedptud)((fixedptd)a.im * a.im);
+
+	s = (s + ((fixedptud)1 << (FIXEDPT_FBITS - 1))) >> FIXEDPT_FBITS;
+	_FIXEDPT_CHECK(s > (fixedptud)FIXEDPT_MAX, FIXEDPT_FN_CABS, FIXEDPT_ERR_SATURATE);
+	return ((s > (fixedptud)FIXEDPT_MAX) ? FIXEDPT_MAX : (fixedpt)s);
+}
+
+/* Returns |a|, saturating at FIXEDPT_MAX */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_cabs(fixedpt_complex a)
+{
+	fixedpt r = _fixedpt_cabs(a.re, a.im);
+
+	/* A clamped result cannot be told from an exact FIXEDPT_MAX */
+	_FIXEDPT_CHECK(r == FIXEDPT_MAX, FIXEDPT_FN_CABS, FIXEDPT_ERR_SATURATE);
+	return (r);
+}
+
+/* Returns the argument of a, in [-pi, pi], or 0 for 0 */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_carg(fixedpt_complex a)
+{
+	return (_fixedpt_pround(_fixedpt_atan2_p(a.im, a.re)));
+}
+
+/*
+ * Returns e^a = e^a.re * (cos(a.im) + i * sin(a.im)). The sine and cosine
+ * share one reduction and keep their guard bits into the final multiply.
+ */
+_FIXEDPT_FUNCTYPE fixedpt_complex fixedpt_cexp(fixedpt_complex a)
+{
+	fixedpt e = fixedpt_exp(a.re);
+	_fixedpt_p s, c;
+	fixedpt_complex r;
+	int flip;
+
+	_fixedpt_sincos_p(_fixedpt_trig_reduce(a.im, &flip), &s, &c);
+	r.re = (fixedpt)_fixedpt_pmul(e, flip ? -c : c, _FIXEDPT_PBITS);
+	r.im = (fixedpt)_fixedpt_pmul(e, s, _FIXEDPT_PBITS);
+	return (r);
+}
+
+/*
+ * Activation functions.
+ *
+ * These avoid fixedpt_exp (and its division) altogether. The logistic
+ * function is interpolated from a table of sigmoid(i/16), 0 <= i <= 256,
+ * by a Hermite spline whose knot derivatives come from the identity
+ * sigmoid' = s * (1 - s). The cubic spline is good to 2^-27, which covers
+ * the usual formats; with more than 26 fraction bits a quintic spline
+ * (which also matches the second derivative) is used instead. That one is
+ * good to 2^-40, which bounds the accuracy with more fraction bits still.
+ * tanh and GELU are derived from the same table.
+ *
+ * The batch forms accept in == out for in-place evaluation.
+ */
+
+/* 1 as a double-width integer, since a Q1 fixedpt cannot hold it */
+#define _FIXEDPT_ONE_D	((fixedptd)1 << FIXEDPT_FBITS)
+
+/* fixedpt_rconst() as a _fixedpt_p, which holds 1 where the core is wide */
+#define _fixedpt_fconst(R) ((_fixedpt_p)((R) * (double)_FIXEDPT_ONE_D + \
+	((R) >= 0 ? 0.5 : -0.5)))
+
+/*
+ * Returns e^-m for the magnitude m as 2^-k * 2^(-j/16) * e^-r, with no
+ * division. m is double-width, since it may exceed the fixedpt range.
+ */
+_FIXEDPT_INLINE fixedpt _fixedpt_exp_neg(fixedptud m)
+{
+#if FIXEDPT_FBITS >= 4
+	static const fixedpt LN2 = fixedpt_rconst(0.69314718055994530942);
+#endif
+	static const fixedpt LOG2E = fixedpt_rconst(1.4426950408889634074);
+	static const fixedpt EXP2_NEG[16] = {
+		fixedpt_rconst(1.0000000000000000),
+		fixedpt_rconst(0.9576032806985737),
+		fixedpt_rconst(0.9170040432046712),
+		fixedpt_rconst(0.8781260801866497),
+		fixedpt_rconst(0.8408964152537145),
+		fixedpt_rconst(0.8052451659746271),
+		fixedpt_rconst(0.7711054127039704),
+		fixedpt_rconst(0.7384130729697497),
+		fixedpt_rconst(0.7071067811865476),
+		fixedpt_rconst(0.6771277734684463),
+		fixedpt_rconst(0.6484197773255048),
+		fixedpt_rconst(0.6209289060367420),
+		fixedpt_rconst(0.5946035575013605),
+		fixedpt_rconst(0.5693943173783458),
+		fixedpt_rconst(0.5452538663326288),
+		fixedpt_rconst(0.5221368912137069)
+	};
+	/* Taylor series of e^-r, r < ln(2)/16, in the type of the polynomial core */
+	static const _fixedpt_p EXP_NEG_P[6] = {
+		_fixedpt_fconst(1.0),
+		_fixedpt_fconst(-1.0),
+		_fixedpt_fconst(1.0 / 2),
+		_fixedpt_fconst(-1.0 / 6),
+		_fixedpt_fconst(1.0 / 24),
+		_fixedpt_fconst(-1.0 / 120)
+	};
+	fixedptud y;
+	fixedpt r, p;
+	int k, j;
+
+	/* e^-m is below half an LSB; this also keeps m * LOG2E in range */
+	if ((m >> FIXEDPT_FBITS) > FIXEDPT_FBITS)
+		return (0);
+
+	/* y = m * log2(e), rounded like fixedpt_mul() */
+	y = (m >> FIXEDPT_FBITS) * LOG2E +
+	    ((((m & FIXEDPT_FMASK) * LOG2E >> (FIXEDPT_FBITS - 1)) + 1) >> 1);
+	k = (int)(y >> FIXEDPT_FBITS);
+	if (k > FIXEDPT_FBITS)
+		return (0);
+#if FIXEDPT_FBITS >= 4
+	j = (int)((y & FIXEDPT_FMASK) >> (FIXEDPT_FBITS - 4));
+	r = fixedpt_mul((fixedpt)(y & (FIXEDPT_FMASK >> 4)), LN2);
+#else
+	/* Too few fraction bits for a remainder r */
+	j = (int)((y & FIXEDPT_FMASK) << (4 - FIXEDPT_FBITS));
+	r = 0;
+#endif
+
+	p = (fixedpt)_fixedpt_poly(r, EXP_NEG_P, 5, FIXEDPT_FBITS, FIXEDPT_POLY_SCHEME);
+	p = fixedpt_mul(EXP2_NEG[j], p);
+	if (k > 0)
+		p = (p + ((fixedpt)1 << (k - 1))) >> k;
+	return (p);
+}
+
+/*
+ * Returns sigmoid(x) for the magnitude x, which is double-width so that
+ * tanh and GELU can pass arguments beyond the fixedpt range.
+ */
+_FIXEDPT_INLINE fixedpt _fixedpt_sigmoid_pos(fixedptud x)
+{
+	static const fixedpt SIG[257] = {
+		fixedpt_rconst(0.5000000000000000), fixedpt_rconst(0.5156199157230156), fixedpt_rconst(0.5312093733737563), fixedpt_rconst(0.5467381519846138),
+		fixedpt_rconst(0.5621765008857981), fixedpt_rconst(0.5774953651858118), fixedpt_rconst(0.5926665999540697), fixedpt_rconst(0.6076631698328917),
+		fixedpt_rconst(0.6224593312018546), fixedpt_rconst(0.6370307944803831), fixedpt_rconst(0.6513548646660542), fixedpt_rconst(0.6654105587468140),
+		fixedpt_rconst(0.6791786991753930), fixedpt_rconst(0.6926419831347361), fixedpt_rconst(0.7057850278370112), fixedpt_rconst(0.7185943925708561),
+		fixedpt_rconst(0.7310585786300049), fixedpt_rconst(0.7431680086124811), fixedpt_rconst(0.7549149868676283), fixedpt_rconst(0.7662936430859597),
+		fixedpt_rconst(0.7772998611746911), fixedpt_rconst(0.7879311956428947), fixedpt_rconst(0.7981867777396212), fixedpt_rconst(0.8080672135527632),
+		fixedpt_rconst(0.8175744761936437), fixedpt_rconst(0.8267117940706734), fixedpt_rconst(0.8354835371034369), fixedpt_rconst(0.8438951025545426),
+		fixedpt_rconst(0.8519528019683106), fixedpt_rconst(0.8596637505099167), fixedpt_rconst(0.8670357598021706), fixedpt_rconst(0.8740772351648677),
+		fixedpt_rconst(0.8807970779778823), fixedpt_rconst(0.8872045937171068), fixedpt_rconst(0.8933094060543487), fixedpt_rconst(0.8991213772699436),
+		fixedpt_rconst(0.9046505351008906), fixedpt_rconst(0.9099070060380482), fixedpt_rconst(0.9149009549929797), fixedpt_rconst(0.9196425311777929),
+		fixedpt_rconst(0.9241418199787566), fixedpt_rconst(0.9284088005554476), fixedpt_rconst(0.9324533088603709), fixedpt_rconst(0.9362850057480346),
+		fixedpt_rconst(0.9399133498259924), fixedpt_rconst(0.9433475746920261), fixedpt_rconst(0.9465966702001757), fixedpt_rconst(0.9496693674025232),
+		fixedpt_rconst(0.9525741268224334), fixedpt_rconst(0.9553191297273498), fixedpt_rconst(0.9579122720843811), fixedpt_rconst(0.9603611608990300),
+		fixedpt_rconst(0.9626731126558706), fixedpt_rconst(0.9648551535992067), fixedpt_rconst(0.9669140216112958), fixedpt_rconst(0.9688561694652216),
+		fixedpt_rconst(0.9706877692486436), fixedpt_rconst(0.9724147177732099), fixedpt_rconst(0.9740426428022031), fixedpt_rconst(0.9755769099458929),
+		fixedpt_rconst(0.9770226300899744), fixedpt_rconst(0.9783846672373524), fixedpt_rconst(0.9796676466573412), fixedpt_rconst(0.9808759632491112),
+		fixedpt_rconst(0.9820137900379085), fixedpt_rconst(0.9830850867332734), fixedpt_rconst(0.9840936082881853), fixedpt_rconst(0.9850429134068500),
+		fixedpt_rconst(0.9859363729567544), fixedpt_rconst(0.9867771782476948), fixedpt_rconst(0.9875683491468141), fixedpt_rconst(0.9883127420043056),
+		fixedpt_rconst(0.9890130573694068), fixedpt_rconst(0.9896718474806949), fixedpt_rconst(0.9902915235185259), fixedpt_rconst(0.9908743626108194),
+		fixedpt_rconst(0.9914225145862881), fixedpt_rconst(0.9919380084717284), fixedpt_rconst(0.9924227587321393), fixedpt_rconst(0.9928785712542649),
+		fixedpt_rconst(0.9933071490757153), fixedpt_rconst(0.9937100978631075), fixedpt_rconst(0.9940889311437562), fixedpt_rconst(0.9944450752963090),
+		fixedpt_rconst(0.9947798743064417), fixedpt_rconst(0.9950945942942779), fixedpt_rconst(0.9953904278206259), fixedpt_rconst(0.9956684979794361),
+		fixedpt_rconst(0.9959298622841040), fixedpt_rconst(0.9961755163553627), fixedpt_rconst(0.9964063974185798), fixedpt_rconst(0.9966233876182606),
+		fixedpt_rconst(0.9968273171575148), fixedpt_rconst(0.9970189672701452), fixedpt_rconst(0.9971990730328789), fixedpt_rconst(0.9973683260251155),
+		fixedpt_rconst(0.9975273768433653), fixedpt_rconst(0.9976768374773688), fixedpt_rconst(0.9978172835546547), fixedpt_rconst(0.9979492564600826),
+		fixedpt_rconst(0.9980732653366725), fixedpt_rconst(0.9981897889737974), fixedpt_rconst(0.9982992775885648), fixedpt_rconst(0.9984021545059827),
+		fixedpt_rconst(0.9984988177432630), fixedpt_rconst(0.9985896415033819), fixedpt_rconst(0.9986749775827868), fixedpt_rconst(0.9987551566979116),
+		fixedpt_rconst(0.9988304897349445), fixedpt_rconst(0.9989012689270753), fixedpt_rconst(0.9989677689632452), fixedpt_rconst(0.9990302480322174),
+		fixedpt_rconst(0.9990889488055994), fixedpt_rconst(0.9991440993632549), fixedpt_rconst(0.9991959140643708), fixedpt_rconst(0.9992445943672705),
+		fixedpt_rconst(0.9992903296008995), fixedpt_rconst(0.9993332976907565), fixedpt_rconst(0.9993736658418905), fixedpt_rconst(0.9994115911814431),
+		fixedpt_rconst(0.9994472213630764), fixedpt_rconst(0.9994806951355050), fixedpt_rconst(0.9995121428772178), fixedpt_rconst(0.9995416870993650),
+		fixedpt_rconst(0.9995694429186754), fixedpt_rconst(0.9995955185021579), fixedpt_rconst(0.9996200154852480), fixedpt_rconst(0.9996430293649623),
+		fixedpt_rconst(0.9996646498695336), fixedpt_rconst(0.9996849613059188), fixedpt_rconst(0.9997040428864870), fixedpt_rconst(0.9997219690361224),
+		fixedpt_rconst(0.9997388096809043), fixedpt_rconst(0.9997546305194572), fixedpt_rconst(0.9997694932780068), fixedpt_rconst(0.9997834559501049),
+		fixedpt_rconst(0.9997965730219448), fixedpt_rconst(0.9998088956841223), fixedpt_rconst(0.9998204720306533), fixedpt_rconst(0.9998313472460109),
+		fixedpt_rconst(0.9998415637808975), fixedpt_rconst(0.9998511615174270), fixedpt_rconst(0.9998601779243528), fixedpt_rconst(0.9998686482029348),
+		fixedpt_rconst(0.9998766054240137), fixedpt_rconst(0.9998840806568136), fixedpt_rconst(0.9998911030899734), fixedpt_rconst(0.9998977001452741),
+		fixedpt_rconst(0.9999038975845005), fixedpt_rconst(0.9999097196098496), fixedpt_rconst(0.9999151889582765), fixedpt_rconst(0.9999203269901391),
+		fixedpt_rconst(0.9999251537724895), fixedpt_rconst(0.9999296881573309), fixedpt_rconst(0.9999339478551454), fixedpt_rconst(0.9999379495039771),
+		fixedpt_rconst(0.9999417087343389), fixedpt_rconst(0.9999452402301955), fixedpt_rconst(0.9999485577862579), fixedpt_rconst(0.9999516743618128),
+		fixedpt_rconst(0.9999546021312976), fixedpt_rconst(0.9999573525318144), fixedpt_rconst(0.9999599363077709), fixedpt_rconst(0.9999623635528191),
+		fixedpt_rconst(0.9999646437492582), fixedpt_rconst(0.9999667858050522), fixedpt_rconst(0.9999687980886061), fixedpt_rconst(0.9999706884614404),
+		fixedpt_rconst(0.9999724643088853), fixedpt_rconst(0.9999741325689185), fixedpt_rconst(0.9999756997592568), fixedpt_rconst(0.9999771720028072),
+		fixedpt_rconst(0.9999785550515792), fixedpt_rconst(0.9999798543091470), fixedpt_rconst(0.9999810748517540), fixedpt_rconst(0.9999822214481369),
+		fixedpt_rconst(0.9999832985781520), fixedpt_rconst(0.9999843104502723), fixedpt_rconst(0.9999852610180254), fixedpt_rconst(0.9999861539954363),
+		fixedpt_rconst(0.9999869928715335), fixedpt_rconst(0.9999877809239794), fixedpt_rconst(0.9999885212318730), fixedpt_rconst(0.9999892166877770),
+		fixedpt_rconst(0.9999898700090192), fixedpt_rconst(0.9999904837483059), fixedpt_rconst(0.9999910603036951), fixedpt_rconst(0.9999916019279651),
+		fixedpt_rconst(0.9999921107374138), fixedpt_rconst(0.9999925887201281), fixedpt_rconst(0.9999930377437499), fixedpt_rconst(0.9999934595627731),
+		fixedpt_rconst(0.9999938558253978), fixedpt_rconst(0.9999942280799697), fixedpt_rconst(0.9999945777810301), fixedpt_rconst(0.9999949062949967),
+		fixedpt_rconst(0.9999952149055051), fixedpt_rconst(0.9999955048184215), fixedpt_rconst(0.9999957771665553), fixedpt_rconst(0.9999960330140850),
+		fixedpt_rconst(0.9999962733607158), fixedpt_rconst(0.9999964991455856), fixedpt_rconst(0.9999967112509346), fixedpt_rconst(0.9999969105055520),
+		fixedpt_rconst(0.9999970976880148), fixedpt_rconst(0.9999972735297293), fixedpt_rconst(0.9999974387177893), fixedpt_rconst(0.9999975938976604),
+		fixedpt_rconst(0.9999977396757020), fixedpt_rconst(0.9999978766215375), fixedpt_rconst(0.9999980052702785), fixedpt_rconst(0.9999981261246162),
+		fixedpt_rconst(0.9999982396567868), fixedpt_rconst(0.9999983463104141), fixedpt_rconst(0.9999984465022453), fixedpt_rconst(0.9999985406237789),
+		fixedpt_rconst(0.9999986290427930), fixedpt_rconst(0.9999987121047844), fixedpt_rconst(0.9999987901343165), fixedpt_rconst(0.9999988634362894),
+		fixedpt_rconst(0.9999989322971299), fixedpt_rconst(0.9999989969859118), fixedpt_rconst(0.9999990577554062), fixedpt_rconst(0.9999991148430695),
+		fixedpt_rconst(0.9999991684719722), fixedpt_rconst(0.9999992188516693), fixedpt_rconst(0.9999992661790194), fixedpt_rconst(0.9999993106389544),
+		fixedpt_rconst(0.9999993524052017), fixedpt_rconst(0.9999993916409633), fixedpt_rconst(0.9999994284995530), fixedpt_rconst(0.9999994631249960),
+		fixedpt_rconst(0.9999994956525918), fixedpt_rconst(0.9999995262094421), fixedpt_rconst(0.9999995549149481), fixedpt_rconst(0.9999995818812769),
+		fixedpt_rconst(0.9999996072137998), fixedpt_rconst(0.9999996310115038), fixedpt_rconst(0.9999996533673789), fixedpt_rconst(0.9999996743687808),
+		fixedpt_rconst(0.9999996940977730), fixedpt_rconst(0.9999997126314468), fixedpt_rconst(0.9999997300422225), fixedpt_rconst(0.9999997463981333),
+		fixedpt_rconst(0.9999997617630899), fixedpt_rconst(0.9999997761971314), fixedpt_rconst(0.9999997897566590), fixedpt_rconst(0.9999998024946565),
+		fixedpt_rconst(0.9999998144608981), fixedpt_rconst(0.9999998257021421), fixedpt_rconst(0.9999998362623136), fixedpt_rconst(0.9999998461826772),
+		fixedpt_rconst(0.9999998555019962), fixedpt_rconst(0.9999998642566865), fixedpt_rconst(0.9999998724809571), fixedpt_rconst(0.9999998802069444),
+		fixedpt_rconst(0.9999998874648379)
+	};
+	fixedpt t, s0, s1, m0, m1, d;
+	int i;
+
+	if ((x >> FIXEDPT_FBITS) >= 16) {
+#if FIXEDPT_FBITS > 22
+		/* 1 - sigmoid(x) = e^-x - e^-2x + ... is still visible in this format */
+		fixedpt e = _fixedpt_exp_neg(x);
+
+		return (FIXEDPT_ONE - e + fixedpt_mul(e, e));
+#else
+		return (FIXEDPT_ONE);
+#endif
+	}
+#if FIXEDPT_FBITS >= 4
+	i = (int)(x >> (FIXEDPT_FBITS - 4));
+#else
+	i = (int)(x << (4 - FIXEDPT_FBITS));
+#endif
+
+	/* Hermite basis on t in [0, 1), derivatives scaled by the knot step */
+	t = (fixedpt)((x & (FIXEDPT_FMASK >> 4)) << 4);
+	s0 = SIG[i];
+	s1 = SIG[i + 1];
+	d = s1 - s0;
+	m0 = fixedpt_mul(s0, (fixedpt)(_FIXEDPT_ONE_D - s0));
+	m1 = fixedpt_mul(s1, (fixedpt)(_FIXEDPT_ONE_D - s1));
+#if FIXEDPT_FBITS > 26
+	{
+		/* Quintic, using sigmoid'' = sigmoid' * (1 - 2s); error < 2^-40 */
+		fixedpt a0 = fixedpt_mul(m0, (fixedpt)(_FIXEDPT_ONE_D - 2 * (fixedptd)s0)) >> 8;
+		fixedpt a1 = fixedpt_mul(m1, (fixedpt)(_FIXEDPT_ONE_D - 2 * (fixedptd)s1)) >> 8;
+
+		m0 >>= 4;
+		m1 >>= 4;
+		return (fixedpt_fma(t, fixedpt_fma(t, fixedpt_fma(t, fixedpt_fma(t,
+		    fixedpt_mla(-15 * d + 8 * m0 + 7 * m1 + ((3 * a0 - 2 * a1) >> 1),
+		    t, 6 * d - 3 * m0 - 3 * m1 - ((a0 - a1) >> 1)),
+		    10 * d - 6 * m0 - 4 * m1 - ((3 * a0 - a1) >> 1)),
+		    a0 >> 1), m0), s0));
+	}
+#else
+	m0 >>= 4;
+	m1 >>= 4;
+	return (fixedpt_fma(t, fixedpt_fma(t,
+	    fixedpt_mla(3 * d - 2 * m0 - m1, t, m0 + m1 - 2 * d), m0), s0));
+#endif
+}
+
+_FIXEDPT_INLINE fixedpt _fixedpt_sigmoid(fixedpt x)
+{
+	if (x < 0)
+		return ((fixedpt)(_FIXEDPT_ONE_D - _fixedpt_sigmoid_pos((fixedptu)-(fixedptu)x)));
+	return (_fixedpt_sigmoid_pos((fixedptu)x));
+}
+
+_FIXEDPT_INLINE fixedpt _fixedpt_tanh(fixedpt x)
+{
+	fixedptu ax = (x < 0) ? -(fixedptu)x : (fixedptu)x;
+	fixedpt t;
+
+	/* tanh(x) = 2 * (sigmoid(2x) - 1/2), with 2x formed double-width */
+	t = 2 * (_fixedpt_sigmoid_pos((fixedptud)ax << 1) - (fixedpt)(_FIXEDPT_ONE_D >> 1));
+	return ((x < 0) ? -t : t);
+}
+
+/*
+ * GELU in the usual tanh form 0.5x(1 + tanh(sqrt(2/pi)(x + 0.044715x^3))),
+ * which is x * sigmoid(2 * sqrt(2/pi)(x + 0.044715x^3)).
+ */
+_FIXEDPT_INLINE fixedpt _fixedpt_gelu(fixedpt x)
+{
+	/* 2 * sqrt(2/pi) exceeds the Q1 range, so both are double-width */
+	static const fixedptud K = (fixedptud)(1.5957691216057307 * (double)_FIXEDPT_ONE_D + 0.5);
+	static const fixedptud KC = (fixedptud)(1.5957691216057307 * 0.044715 * (double)_FIXEDPT_ONE_D + 0.5);
+	const fixedptud half = (fixedptud)_FIXEDPT_ONE_D >> 1;
+	fixedptud ax = (fixedptu)((x < 0) ? -(fixedptu)x : (fixedptu)x);
+	fixedptud u;
+	fixedpt g;
+
+	/* Beyond |x| = 8 the gate is 0 or 1 to well below 2^-64 */
+	if (ax >> (FIXEDPT_FBITS + 3))
+		return ((x < 0) ? 0 : x);
+
+	/* |u| reaches 49 at |x| = 8, so it is formed double-width */
+	u = (KC * ax + half) >> FIXEDPT_FBITS;
+	u = (u * ax + half) >> FIXEDPT_FBITS;
+	u = (ax * (K + u) + half) >> FIXEDPT_FBITS;
+	g = _fixedpt_sigmoid_pos(u);
+	return (fixedpt_mul(x, (x < 0) ? (fixedpt)(_FIXEDPT_ONE_D - g) : g));
+}
+
+/* Returns the logistic function 1 / (1 + e^-x) of the given fixedpt number */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_sigmoid(fixedpt x)
+{
+	return (_fixedpt_sigmoid(x));
+}
+
+/* Returns the hyperbolic tangent of the given fixedpt number */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_tanh(fixedpt x)
+{
+	return (_fixedpt_tanh(x));
+}
+
+/* Returns the GELU activation of the given fixedpt number */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_gelu(fixedpt x)
+{
+	return (_fixedpt_gelu(x));
+}
+
+/*
+ * Softmax kernel, see fixedpt_softmax()
+ */
+_FIXEDPT_INLINE void _fixedpt_softmax_kernel(const fixedpt *in, fixedpt *out, size_t n)
+{
+	const int shift = 2 * FIXEDPT_BITS - 2 - FIXEDPT_FBITS;
+	fixedptd sum = 0, inv;
+	fixedpt max;
+	size_t i;
+
+	if (n == 0)
+		return;
+
+	max = in[0];
+	for (i = 1; i < n; i++)
+		if (in[i] > max)
+			max = in[i];
+
+	for (i = 0; i < n; i++) {
+		out[i] = _fixedpt_exp_neg((fixedptud)((fixedptd)max - in[i]));
+		sum += out[i];
+	}
+
+	inv = ((fixedptd)1 << (2 * FIXEDPT_BITS - 2)) / sum;
+	for (i = 0; i < n; i++)
+		out[i] = (fixedpt)(((fixedptd)out[i] * inv + ((fixedptd)1 << (shift - 1))) >> shift);
+}
+
+#ifndef FIXEDPT_NO_FLOAT
+/*
+ * Array conversions between fixedpt and float/double. Unlike the
+ * fixedpt_tofloat and fixedpt_todouble macros these are real functions,
+ * so they are left out when FIXEDPT_NO_FLOAT is defined.
+ *
+ * The from_* functions round half away from zero (like fixedpt_rconst)
+ * or truncate toward zero, depending on the round argument. Inputs outside
+ * the fixedpt range saturate to FIXEDPT_MIN/FIXEDPT_MAX, NaNs become zero,
+ * and the number of saturated elements is returned.
+ */
+
+/*
+ * Converts one scaled float to fixedpt and sets *sat to whether it
+ * saturated. There are no branches, so that the array loops vectorize.
+ * Out of range values and NaN are zeroed by masking their bits, which
+ * makes the conversion always defined, and the saturated ends are or-ed
+ * in afterwards. A select would do the same, but the compiler turns it
+ * back into a branch, since the float operations after it could trap.
+ * The limits are compared against v - hi and v + hi, which are exact near
+ * them, as hi + lim is not in 32-bit and 64-bit builds.
+ */
+_FIXEDPT_INLINE fixedpt _fixedpt_from_float(float v, int round, int *sat)
+{
+	const float hi = (float)((fixedptu)1 << (FIXEDPT_BITS - 1));
+	const float lim = (round == FIXEDPT_ROUND_NEAREST) ? 0.5f : 1.0f;
+	int over = (v - hi >= lim - 1.0f), under = (v + hi <= -lim);
+	union { float f; uint32_t u; } c;
+	fixedpt t;
+
+	c.f = v;
+	c.u &= -(uint32_t)((v - hi < lim - 1.0f) & (v + hi > -lim));
+	t = (fixedpt)c.f;
+
+	/* c - t is exact and below 1 in magnitude, so 2 (c - t) truncates to the step */
+	if (round == FIXEDPT_ROUND_NEAREST)
+		t += (fixedpt)((c.f - (float)t) * 2.0f);
+
+	/* t is zero here if it saturated; FIXEDPT_MAX + 1 wraps to FIXEDPT_MIN */
+	t |= (fixedpt)((fixedptu)(FIXEDPT_MAX + (fixedptu)under) & (fixedptu)-(fixedptu)(over | under));
+	*sat = over | under;
+	return (t);
+}
+
+/* Converts one scaled double to fixedpt, as _fixedpt_from_float() */
+_FIXEDPT_INLINE fixedpt _fixedpt_from_double(double v, int round, int *sat)
+{
+	const double hi = (double)((fixedptu)1 << (FIXEDPT_BITS - 1));
+	const double lim = (round == FIXEDPT_ROUND_NEAREST) ? 0.5 : 1.0;
+	int over = (v - hi >= lim - 1.0), under = (v + hi <= -lim);
+	union { double f; uint64_t u; } c;
+	fixedpt t;
+
+	c.f = v;
+	c.u &= -(uint64_t)((v - hi < lim - 1.0) & (v + hi > -lim));
+	t = (fixedpt)c.f;
+	if (round == FIXEDPT_ROUND_NEAREST)
+		t += (fixedpt)((c.f - (double)t) * 2.0);
+	t |= (fixedpt)((fixedptu)(FIXEDPT_MAX + (fixedptu)under) & (fixedptu)-(fixedptu)(over | under));
+	*sat = over | under;
+	return (t);
+}
+
+/* One loop per rounding mode, so that neither tests the mode per element */
+_FIXEDPT_INLINE void _fixedpt_from_float_kernel(const float *in, fixedpt *out, size_t n, int round, size_t *nsat)
+{
+	const float scale = (float)((fixedptud)1 << FIXEDPT_FBITS);
+	size_t i, cnt = 0;
+	int sat;
+
+	if (round == FIXEDPT_ROUND_NEAREST) {
+		for (i = 0; i < n; i++) {
+			out[i] = _fixedpt_from_float(in[i] * scale, FIXEDPT_ROUND_NEAREST, &sat);
+			cnt += sat;
+		}
+	} else {
+		for (i = 0; i < n; i++) {
+			out[i] = _fixedpt_from_float(in[i] * scale, FIXEDPT_ROUND_TRUNCATE, &sat);
+			cnt += sat;
+		}
+	}
+	*nsat = cnt;
+}
+
+_FIXEDPT_INLINE void _fixedpt_from_double_kernel(const double *in, fixedpt *out, size_t n, int round, size_t *nsat)
+{
+	const double scale = (double)((fixedptud)1 << FIXEDPT_FBITS);
+	size_t i, cnt = 0;
+	int sat;
+
+	if (round == FIXEDPT_ROUND_NEAREST) {
+		for (i = 0; i < n; i++) {
+			out[i] = _fixedpt_from_double(in[i] * scale, FIXEDPT_ROUND_NEAREST, &sat);
+			cnt += sat;
+		}
+	} else {
+		for (i = 0; i < n; i++) {
+			out[i] = _fixedpt_from_double(in[i] * scale, FIXEDPT_ROUND_TRUNCATE, &sat);
+			cnt += sat;
+		}
+	}
+	*nsat = cnt;
+}
+
+_FIXEDPT_INLINE void _fixedpt_to_float_kernel(const fixedpt *in, float *out, size_t n)
+{
+	const float scale = 1.0f / (float)((fixedptud)1 << FIXEDPT_FBITS);
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = (float)in[i] * scale;
+}
+
+_FIXEDPT_INLINE void _fixedpt_to_double_kernel(const fixedpt *in, double *out, size_t n)
+{
+	const double scale = 1.0 / (double)((fixedptud)1 << FIXEDPT_FBITS);
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = (double)in[i] * scale;
+}
+#endif
+
+/*
+ * Bit-packed arrays.
+ *
+ * A block is an optional header word (the minimum as an int64 for
+ * FIXEDPT_PACK_OFFSET, the exponent for FIXEDPT_PACK_EXPONENT) followed
+ * by width 64-bit words holding FIXEDPT_PACK_BLOCK fields of width bits,
+ * least significant first. Every block has the same size, so element i
+ * is found without decoding anything before it, and one guard word after
+ * the last block lets every field be read as two whole-word loads.
+ * The words are in host byte order; this is a memory format, write it to
+ * files through fixedpt_file_write() of the unpacked data or as raw bytes
+ * between hosts of the same byte order.
+ */
+#define _FIXEDPT_PACK_HEAD(mode)	((mode) != FIXEDPT_PACK_PLAIN)
+
+/* Whether width and mode describe a packed array; other shifts are undefined */
+#define _FIXEDPT_PACK_VALID(width, mode) ((width) >= 1 && (width) <= FIXEDPT_BITS && \
+	(mode) >= FIXEDPT_PACK_PLAIN && (mode) <= FIXEDPT_PACK_EXPONENT)
+
+_FIXEDPT_INLINE uint64_t _fixedpt_pack_field(const uint64_t *w, size_t bit)
+{
+	unsigned sh = (unsigned)(bit & 63);
+
+	/* The second load supplies the bits of fields crossing a word */
+	return ((w[bit >> 6] >> sh) | ((w[(bit >> 6) + 1] << 1) << (63 - sh)));
+}
+
+/* Decodes the FIXEDPT_PACK_BLOCK elements of one block */
+_FIXEDPT_INLINE void _fixedpt_unpack_kernel(const uint64_t *blk, int width, int mode, fixedpt *out)
+{
+	const uint64_t *w = blk + _FIXEDPT_PACK_HEAD(mode);
+	const int up = 64 - width;
+	int j;
+
+	if (mode == FIXEDPT_PACK_OFFSET) {
+		const uint64_t base = blk[0];
+
+		for (j = 0; j < FIXEDPT_PACK_BLOCK; j++)
+			out[j] = (fixedpt)(base + ((_fixedpt_pack_field(w,
+			    (size_t)j * width) << up) >> up));
+	} else {
+		const int e = (mode == FIXEDPT_PACK_EXPONENT) ? (int)blk[0] : 0;
+
+		for (j = 0; j < FIXEDPT_PACK_BLOCK; j++)
+			out[j] = (fixedpt)((uint64_t)((int64_t)(_fixedpt_pack_field(w,
+			    (size_t)j * width) << up) >> up) << e);
+	}
+}
+
+/* Encodes len <= FIXEDPT_PACK_BLOCK elements, returns the number saturated */
+static size_t _fixedpt_pack_block(const fixedpt *in, size_t len, int width, int mode, uint64_t *blk)
+{
+	uint64_t *w = blk + _FIXEDPT_PACK_HEAD(mode);
+	const uint64_t mask = (width == 64) ? ~(uint64_t)0 : ((uint64_t)1 << width) - 1;
+	const int64_t fmax = (int64_t)(mask >> 1), fmin = -fmax - 1;
+	size_t j, nsat = 0;
+	fixedpt min = FIXEDPT_MAX;
+	uint64_t mag = 0;
+	int e = 0;
+
+	for (j = 0; j < (size_t)width; j++)
+		w[j] = 0;
+	if (mode == FIXEDPT_PACK_OFFSET) {
+		for (j = 0; j < len; j++)
+			min = (in[j] < min) ? in[j] : min;
+		blk[0] = (uint64_t)(int64_t)min;
+	} else if (mode == FIXEDPT_PACK_EXPONENT) {
+		/* The smallest shift that fits the largest magnitude */
+		for (j = 0; j < len; j++)
+			mag |= (uint64_t)((in[j] < 0) ? ~(int64_t)in[j] : (int64_t)in[j]);
+		while (e < 63 && (mag >> e) > (uint64_t)fmax)
+			e++;
+		blk[0] = (uint64_t)e;
+	}
+
+	for (j = 0; j < len; j++) {
+		size_t bit = j * (size_t)width;
+		unsigned sh = (unsigned)(bit & 63);
+		uint64_t f;
+
+		if (mode == FIXEDPT_PACK_OFFSET) {
+			f = (uint64_t)(fixedptu)((fixedptu)in[j] - (fixedptu)min);
+			if (f > mask) {
+				f = mask;
+				nsat++;
+			}
+		} else {
+			int64_t v = in[j];
+
+			if (e > 0) {
+				/* Rounding can only step one unit past fmax */
+				v = ((v >> (e - 1)) + 1) >> 1;
+				v = (v > fmax) ? fmax : v;
+			} else if (v > fmax || v < fmin) {
+				v = (v > fmax) ? fmax : fmin;
+				nsat++;
+			}
+			f = (uint64_t)v & mask;
+		}
+		w[bit >> 6] |= f << sh;
+		if (sh + width > 64)
+			w[(bit >> 6) + 1] |= f >> (64 - sh);
+	}
+	return (nsat);
+}
+
+/*
+ * Reductions.
+ *
+ * The sums are exact. Elements are added into a fixedpt_acc, and each
+ * square is formed exactly in fixedptd and its high and low halves are
+ * summed separately, which needs no carry between lanes and holds
+ * 2^(FIXEDPT_BITS - 1) squares per pass of the kernel. Welford's update
+ * exists to avoid the cancellation of sum x^2 - (sum x)^2 / n in floating
+ * point; with exact integer sums that formula loses nothing, costs no
+ * division per element, and a sliding window can subtract exactly what
+ * it added. The loops are plain widening sums, min/max and multiplies,
+ * which the AVX2 and AVX-512 variants vectorize; 64-bit builds sum in
+ * __int128 and stay scalar.
+ */
+
+/* Elements per pass of the moments kernel, below its overflow bound */
+#define _FIXEDPT_MOMENTS_CHUNK	((size_t)1 << 30)
+
+/* Moves the carries of sumsq_lo into sumsq_hi */
+_FIXEDPT_INLINE void _fixedpt_stats_norm(fixedpt_stats *s)
+{
+	fixedpt_acc c = s->sumsq_lo >> FIXEDPT_BITS;
+
+	s->sumsq_hi += c;
+	s->sumsq_lo -= c * ((fixedpt_acc)1 << FIXEDPT_BITS);
+}
+
+/*
+ * Returns (hi * 2^FIXEDPT_BITS + lo) / n, rounded down, for hi >= 0 and
+ * 0 <= lo < 2^FIXEDPT_BITS. The long division goes in half words so no
+ * step overflows for any count of elements a stream can reach.
+ */
+static fixedpt_acc _fixedpt_acc2_div(fixedpt_acc hi, fixedpt_acc lo, fixedpt_acc n)
+{
+	const int h = FIXEDPT_BITS / 2;
+	fixedpt_acc q, t;
+
+	q = (hi / n) * ((fixedpt_acc)1 << FIXEDPT_BITS);
+	t = ((hi % n) << h) + (lo >> h);
+	q += (t / n) << h;
+	t = ((t % n) << h) + (lo & (((fixedpt_acc)1 << h) - 1));
+	return (q + t / n);
+}
+
+/* Returns a / n, rounded to nearest */
+_FIXEDPT_INLINE fixedpt_acc _fixedpt_acc_div(fixedpt_acc a, uint64_t n)
+{
+	fixedpt_acc h = (fixedpt_acc)(n >> 1);
+
+	return (((a < 0) ? a - h : a + h) / (fixedpt_acc)n);
+}
+
+/* Returns sqrt(a) rounded to nearest, for a >= 0 */
+static fixedpt_acc _fixedpt_acc_sqrt(fixedpt_acc a)
+{
+	fixedpt_acc r = 0, b = (fixedpt_acc)1 << (sizeof(fixedpt_acc) * 8 - 2);
+
+	while (b > a)
+		b >>= 2;
+	for (; b != 0; b >>= 2) {
+		if (a >= r + b) {
+			a -= r + b;
+			r = (r >> 1) + b;
+		} else {
+			r >>= 1;
+		}
+	}
+	/* a is now the remainder x - r^2, and (r + 1/2)^2 = r^2 + r + 1/4 */
+	return ((a > r) ? r + 1 : r);
+}
+
+/* Histogram bins: [lo, lo + range) in nbins bins of width w, m = ~0 / w */
+struct _fixedpt_bins {
+	fixedpt lo;
+	fixedptu range, w, m, nbins;
+};
+
+_FIXEDPT_INLINE void _fixedpt_sum_kernel(const fixedpt *in, size_t n, fixedpt_acc *sum)
+{
+	fixedpt_acc s = 0;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		s += in[i];
+	*sum = s;
+}
+
+/* Adds the sum of n elements and of their squares, split in halves, to *s */
+_FIXEDPT_INLINE void _fixedpt_moments_kernel(const fixedpt *in, size_t n, fixedpt_stats *s)
+{
+	fixedpt_acc sum = 0, hi = 0, lo = 0;
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		fixedptud sq = (fixedptud)((fixedptd)in[i] * in[i]);
+
+		sum += in[i];
+		hi += (fixedpt_acc)(sq >> FIXEDPT_BITS);
+		lo += (fixedpt_acc)(fixedptu)sq;
+	}
+	s->sum += sum;
+	s->sumsq_hi += hi;
+	s->sumsq_lo += lo;
+}
+
+_FIXEDPT_INLINE void _fixedpt_minmax_kernel(const fixedpt *in, size_t n, fixedpt *min, fixedpt *max)
+{
+	fixedpt lo = FIXEDPT_MAX, hi = FIXEDPT_MIN;
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		lo = (in[i] < lo) ? in[i] : lo;
+		hi = (in[i] > hi) ? in[i] : hi;
+	}
+	*min = lo;
+	*max = hi;
+}
+
+/*
+ * Stores the bin of each element into idx, or b->nbins if it is outside.
+ * The quotient (x - lo) / w comes from a multiply by the reciprocal m,
+ * which is at most two short, and two branchless corrections.
+ */
+_FIXEDPT_INLINE void _fixedpt_hist_kernel(const fixedpt *in, size_t n, const struct _fixedpt_bins *b, fixedptu *idx)
+{
+	const fixedptu range = b->range, w = b->w, m = b->m, nbins = b->nbins;
+	const fixedptu lo = (fixedptu)b->lo;
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		fixedptu u = (fixedptu)((fixedptu)in[i] - lo);
+		fixedptu q = (fixedptu)(((fixedptud)u * m) >> FIXEDPT_BITS);
+
+		q += (fixedptu)(u - (fixedptu)((fixedptud)q * w) >= w);
+		q += (fixedptu)(u - (fixedptu)((fixedptud)q * w) >= w);
+		/* The last bin takes the remainder of range / nbins */
+		q = (q < nbins) ? q : (fixedptu)(nbins - 1);
+		idx[i] = (u < range) ? q : nbins;
+	}
+}
+
+/*
+ * Lookup tables.
+ *
+ * A uniform axis finds the segment of x with a subtraction and a shift,
+ * and the offset into it with a mask. A non-uniform axis first tries the
+ * segment of the previous lookup and the one after it, which is where a
+ * sampled signal usually is, and otherwise runs a binary search whose
+ * steps are conditional moves, so its cost does not depend on the data.
+ * Nothing divides at evaluation time: uniform segments interpolate by a
+ * shift, non-uniform 1D segments by a slope computed at build time, and
+ * non-uniform 2D axes by a reciprocal width computed at build time. Each
+ * slope and reciprocal carries its own shift, so a table mixing steep and
+ * flat or narrow and wide segments keeps full precision in all of them.
+ * Inputs outside the grid are clamped to it.
+ */
+
+/* Finds the segment of v on a uniform axis, see _fixedpt_lut_find() */
+_FIXEDPT_INLINE size_t _fixedpt_lut_find_u(const fixedpt_lut_axis *a, fixedpt v, fixedptu *t)
+{
+	const fixedptd end = (fixedptd)(a->n - 1) << a->step;
+	fixedptd u = (fixedptd)v - a->x0;
+
+	u = (u < 0) ? 0 : (u > end) ? end : u;
+	*t = (fixedptu)u & (fixedptu)(((fixedptu)1 << a->step) - 1);
+	return ((size_t)(u >> a->step));
+}
+
+/* Finds the segment of v on a non-uniform axis, see _fixedpt_lut_find() */
+_FIXEDPT_INLINE size_t _fixedpt_lut_find_p(const fixedpt_lut_axis *a, fixedpt v, size_t *hint, fixedptu *t)
+{
+	const fixedpt *x = a->x, *base = x;
+	size_t k = *hint, len, half;
+
+	v = (v < x[0]) ? x[0] : (v > x[a->n - 1]) ? x[a->n - 1] : v;
+	if (k + 2 < a->n && ((x[k] <= v) & (v < x[k + 2]))) {
+		/* One test covers the hinted segment and the next */
+		k += (x[k + 1] <= v);
+	} else {
+		for (len = a->n; len > 1; len -= half) {
+			half = len >> 1;
+			base = (base[half] <= v) ? base + half : base;
+		}
+		k = (size_t)(base - x);
+	}
+	*hint = k;
+	*t = (fixedptu)((fixedptu)v - (fixedptu)x[k]);
+	return (k);
+}
+
+/*
+ * Returns the segment k of v on the axis, x_k <= v < x_k+1, and stores
+ * v - x_k in *t, after clamping v to the grid. k is n - 1, with *t 0,
+ * only at or past the last breakpoint.
+ */
+_FIXEDPT_INLINE size_t _fixedpt_lut_find(const fixedpt_lut_axis *a, fixedpt v, size_t *hint, fixedptu *t)
+{
+	if (a->x == NULL)
+		return (_fixedpt_lut_find_u(a, v, t));
+	return (_fixedpt_lut_find_p(a, v, hint, t));
+}
+
+/* Interpolates a uniform 1D table in segment k */
+_FIXEDPT_INLINE fixedpt _fixedpt_lut_u(const fixedpt_lut *lut, size_t k, fixedptu t)
+{
+	const fixedpt *y = lut->y;
+	const size_t k1 = (k + 1 < lut->a.n) ? k + 1 : k;
+
+	return ((fixedpt)(y[k] + ((((fixedptd)y[k1] - y[k]) * t +
+	    (((fixedptd)1 << lut->a.step) >> 1)) >> lut->a.step)));
+}
+
+/* Interpolates a non-uniform 1D table in segment k */
+_FIXEDPT_INLINE fixedpt _fixedpt_lut_p(const fixedpt_lut *lut, size_t k, fixedptu t)
+{
+	const fixedpt_lut_seg *m = &lut->slope[(k + 1 < lut->a.n) ? k : k - 1];
+
+	return ((fixedpt)(lut->y[k] + (((fixedptd)m->m * t +
+	    (((fixedptd)1 << m->shift) >> 1)) >> m->shift)));
+}
+
+/* Returns the offset t into segment k as a fraction with FIXEDPT_BITS - 2 bits */
+_FIXEDPT_INLINE fixedptd _fixedpt_lut_frac(const fixedpt_lut_axis *a, const fixedpt_lut_seg *recip,
+    size_t k, fixedptu t)
+{
+	if (a->x == NULL)
+		return ((fixedptd)t << (FIXEDPT_BITS - 2 - a->step));
+	recip += (k + 1 < a->n) ? k : k - 1;
+	return ((fixedptd)(((fixedptud)t * (fixedptu)recip->m) >> recip->shift));
+}
+
+/* Returns a + (b - a) * f for a fraction f with FIXEDPT_BITS - 2 bits, rounded */
+_FIXEDPT_INLINE fixedptd _fixedpt_lut_lerp(fixedptd a, fixedptd b, fixedptd f)
+{
+	return (a + (((b - a) * f + ((fixedptd)1 << (FIXEDPT_BITS - 3))) >> (FIXEDPT_BITS - 2)));
+}
+
+_FIXEDPT_INLINE fixedpt _fixedpt_lut2(const fixedpt_lut2 *lut, fixedpt x, fixedpt y, size_t *hx, size_t *hy)
+{
+	const size_t nx = lut->a[0].n;
+	fixedptu tx, ty;
+	size_t i = _fixedpt_lut_find(&lut->a[0], x, hx, &tx);
+	size_t j = _fixedpt_lut_find(&lut->a[1], y, hy, &ty);
+	const size_t i1 = (i + 1 < nx) ? i + 1 : i;
+	const fixedpt *r0 = lut->z + j * nx;
+	const fixedpt *r1 = (j + 1 < lut->a[1].n) ? r0 + nx : r0;
+	fixedptd fx = _fixedpt_lut_frac(&lut->a[0], lut->recip[0], i, tx);
+	fixedptd fy = _fixedpt_lut_frac(&lut->a[1], lut->recip[1], j, ty);
+
+	return ((fixedpt)_fixedpt_lut_lerp(_fixedpt_lut_lerp(r0[i], r0[i1], fx),
+	    _fixedpt_lut_lerp(r1[i], r1[i1], fx), fy));
+}
+
+/*
+ * The uniform loop keeps no state from one element to the next; the
+ * non-uniform loop threads the search hint through, so that sorted or
+ * slowly varying inputs find their segment in a step or two.
+ */
+_FIXEDPT_INLINE void _fixedpt_lut_kernel(const fixedpt_lut *lut, const fixedpt *in, fixedpt *out, size_t n,
+    size_t *hint)
+{
+	size_t i, k, h = *hint;
+	fixedptu t;
+
+	if (lut->a.x == NULL) {
+		for (i = 0; i < n; i++) {
+			k = _fixedpt_lut_find_u(&lut->a, in[i], &t);
+			out[i] = _fixedpt_lut_u(lut, k, t);
+		}
+	} else {
+		for (i = 0; i < n; i++) {
+			k = _fixedpt_lut_find_p(&lut->a, in[i], &h, &t);
+			out[i] = _fixedpt_lut_p(lut, k, t);
+		}
+	}
+	*hint = h;
+}
+
+_FIXEDPT_INLINE void _fixedpt_lut2_kernel(const fixedpt_lut2 *lut, const fixedpt *x, const fixedpt *y,
+    fixedpt *out, size_t n, size_t *hint)
+{
+	size_t i, hx = hint[0], hy = hint[1];
+
+	for (i = 0; i < n; i++)
+		out[i] = _fixedpt_lut2(lut, x[i], y[i], &hx, &hy);
+	hint[0] = hx;
+	hint[1] = hy;
+}
+
+/*
+ * Random numbers.
+ *
+ * Each value is made from the integer bits of one 64-bit output: the top
+ * bits of a uniform, or a multiply-high by the width of a range, which
+ * leaves a bias of at most width / 2^64. The normal variates come from a
+ * 128-layer ziggurat, whose common case is one comparison and one
+ * multiply; its wedges and tail (about 1.2% of draws) take exp and ln.
+ */
+
+/* Draw kinds of _fixedpt_rng_kernel() */
+#define _FIXEDPT_RNG_UNIFORM	0
+#define _FIXEDPT_RNG_RANGE	1
+#define _FIXEDPT_RNG_TRIANGULAR	2
+
+_FIXEDPT_INLINE uint64_t _fixedpt_rotl64(uint64_t x, int k)
+{
+	return ((x << k) | (x >> (64 - k)));
+}
+
+/* Returns the next output of SplitMix64, which seeds the lanes */
+_FIXEDPT_INLINE uint64_t _fixedpt_splitmix64(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return (z ^ (z >> 31));
+}
+
+/* Steps lane j of the state words and returns its output */
+_FIXEDPT_INLINE uint64_t _fixedpt_xoshiro(uint64_t *s0, uint64_t *s1, uint64_t *s2, uint64_t *s3, int j)
+{
+	uint64_t r = _fixedpt_rotl64(s0[j] + s3[j], 23) + s0[j];
+	uint64_t t = s1[j] << 17;
+
+	s2[j] ^= s0[j];
+	s3[j] ^= s1[j];
+	s1[j] ^= s2[j];
+	s0[j] ^= s3[j];
+	s2[j] ^= t;
+	s3[j] = _fixedpt_rotl64(s3[j], 45);
+	return (r);
+}
+
+/* Returns floor(r * w / 2^64) */
+_FIXEDPT_INLINE fixedptu _fixedpt_rng_scale(uint64_t r, fixedptu w)
+{
+#if FIXEDPT_BITS == 64
+	return ((fixedptu)(((fixedptud)r * w) >> 64));
+#else
+	/* floor((hi * 2^32 + lo) * w / 2^64), with the low product's carry */
+	uint64_t hi = (r >> 32) * w;
+	uint64_t lo = ((r & 0xffffffffULL) * w) >> 32;
+
+	return ((fixedptu)((hi + lo) >> 32));
+#endif
+}
+
+/*
+ * Maps 64 random bits to a draw of the given kind: a uniform in [0, 1),
+ * lo + a uniform in [0, w), or (u1 - u2) * w for two uniforms u1 and u2
+ * in [0, 1) of up to 31 bits each, rounded towards 0 so that it stays
+ * symmetric and inside (-w, w).
+ */
+_FIXEDPT_INLINE fixedpt _fixedpt_rng_conv(uint64_t r, int kind, fixedpt lo, fixedptu w)
+{
+#if FIXEDPT_BITS > 32
+	const int h = 32;
+#else
+	const int h = FIXEDPT_BITS;
+#endif
+	fixedptd t;
+
+	if (kind == _FIXEDPT_RNG_UNIFORM)
+		return ((fixedpt)(r >> (64 - FIXEDPT_FBITS)));
+	if (kind == _FIXEDPT_RNG_RANGE)
+		return ((fixedpt)((fixedptu)lo + _fixedpt_rng_scale(r, w)));
+	t = (fixedptd)(r >> (65 - h)) - (fixedptd)((r >> (33 - h)) & ((1ULL << (h - 1)) - 1));
+	return ((fixedpt)((t * (fixedptd)w) / ((fixedptd)1 << (h - 1))));
+}
+
+/* Steps all lanes once, into rng->buf */
+_FIXEDPT_INLINE void _fixedpt_rng_step(fixedpt_rng *rng)
+{
+	int j;
+
+	for (j = 0; j < FIXEDPT_RNG_LANES; j++)
+		rng->buf[j] = _fixedpt_xoshiro(rng->s[0], rng->s[1], rng->s[2], rng->s[3], j);
+	rng->pos = 0;
+}
+
+/* Returns the next 64 random bits */
+_FIXEDPT_INLINE uint64_t _fixedpt_rng_next(fixedpt_rng *rng)
+{
+	if (rng->pos == FIXEDPT_RNG_LANES)
+		_fixedpt_rng_step(rng);
+	return (rng->buf[rng->pos++]);
+}
+
+/*
+ * Steps all lanes nblk times, writing one draw of the given kind per
+ * output. The state is copied into locals so that it cannot alias out.
+ */
+_FIXEDPT_INLINE void _fixedpt_rng_kernel(fixedpt_rng *rng, fixedpt *out, size_t nblk, int kind,
+    fixedpt lo, fixedptu w)
+{
+	uint64_t s0[FIXEDPT_RNG_LANES], s1[FIXEDPT_RNG_LANES];
+	uint64_t s2[FIXEDPT_RNG_LANES], s3[FIXEDPT_RNG_LANES];
+	size_t b;
+	int j;
+
+	for (j = 0; j < FIXEDPT_RNG_LANES; j++) {
+		s0[j] = rng->s[0][j];
+		s1[j] = rng->s[1][j];
+		s2[j] = rng->s[2][j];
+		s3[j] = rng->s[3][j];
+	}
+	for (b = 0; b < nblk; b++, out += FIXEDPT_RNG_LANES) {
+		for (j = 0; j < FIXEDPT_RNG_LANES; j++)
+			out[j] = _fixedpt_rng_conv(_fixedpt_xoshiro(s0, s1, s2, s3, j), kind, lo, w);
+	}
+	for (j = 0; j < FIXEDPT_RNG_LANES; j++) {
+		rng->s[0][j] = s0[j];
+		rng->s[1][j] = s1[j];
+		rng->s[2][j] = s2[j];
+		rng->s[3][j] = s3[j];
+	}
+}
+
+#if FIXEDPT_WBITS >= 6
+/* The ziggurat's layer widths x_i have FIXEDPT_BITS - 3 fraction bits */
+#define _FIXEDPT_ZIG_XBITS	(FIXEDPT_BITS - 3)
+#define _FIXEDPT_ZIG_X(R)	((fixedpt)((R) * (double)((fixedptud)1 << _FIXEDPT_ZIG_XBITS) + 0.5))
+#define _FIXEDPT_ZIG_K(R)	((fixedptu)((R) * (double)((fixedptud)1 << (FIXEDPT_BITS - 1))))
+
+/* Returns -ln((k + 1) / 2^31), from ln of the mantissa of k + 1 */
+_FIXEDPT_INLINE fixedpt _fixedpt_rng_neglog(uint32_t k)
+{
+	static const fixedpt LN2 = fixedpt_rconst(0.69314718055994530942);
+	uint64_t v = (uint64_t)k + 1;
+	int b = 31;
+
+	fixedpt m;
+
+	while ((v >> b) == 0)
+		b--;
+	m = (b > FIXEDPT_FBITS) ? (fixedpt)(v >> (b - FIXEDPT_FBITS)) :
+	    (fixedpt)((fixedptu)v << (FIXEDPT_FBITS - b));
+	return ((fixedpt)((31 - b) * LN2) - fixedpt_ln(m));
+}
+
+/*
+ * Returns a standard normal variate, by Marsaglia and Tsang's ziggurat
+ * of 128 layers. The low 7 bits of a draw pick the layer and the top
+ * FIXEDPT_BITS bits are a signed fraction u of its width x_i; u * x_i is
+ * accepted at once if |u| < K[i] = x_(i-1) / x_i. In 64-bit builds the
+ * two overlap, but only below the precision of the result.
+ */
+_FIXEDPT_INLINE fixedpt _fixedpt_rng_normal(fixedpt_rng *rng)
+{
+	/* x_0 = v / f(r) for the base layer, x_127 = r */
+	static const fixedpt X[128] = {
+		_FIXEDPT_ZIG_X(3.7130862467425505), _FIXEDPT_ZIG_X(0.27232086481396467), _FIXEDPT_ZIG_X(0.36287143109703196), _FIXEDPT_ZIG_X(0.42654798635542351),
+		_FIXEDPT_ZIG_X(0.47743783729668982), _FIXEDPT_ZIG_X(0.52065603876206057), _FIXEDPT_ZIG_X(0.55869217840818519), _FIXEDPT_ZIG_X(0.59296294247144832),
+		_FIXEDPT_ZIG_X(0.6243585973360507), _FIXEDPT_ZIG_X(0.65347863873997525), _FIXEDPT_ZIG_X(0.68074791866915463), _FIXEDPT_ZIG_X(0.70647961133543646),
+		_FIXEDPT_ZIG_X(0.73091191064248884), _FIXEDPT_ZIG_X(0.75423066445405562), _FIXEDPT_ZIG_X(0.77658398789475991), _FIXEDPT_ZIG_X(0.79809206064405691),
+		_FIXEDPT_ZIG_X(0.81885390670035729), _FIXEDPT_ZIG_X(0.83895221429757738), _FIXEDPT_ZIG_X(0.85845684319381321), _FIXEDPT_ZIG_X(0.87742742911292337),
+		_FIXEDPT_ZIG_X(0.89591535258093769), _FIXEDPT_ZIG_X(0.91396525102303228), _FIXEDPT_ZIG_X(0.93161619661515083), _FIXEDPT_ZIG_X(0.94890262551130644),
+		_FIXEDPT_ZIG_X(0.9658550794011499), _FIXEDPT_ZIG_X(0.98250080351542901), _FIXEDPT_ZIG_X(0.99886423349298359), _FIXEDPT_ZIG_X(1.0149673952513305),
+		_FIXEDPT_ZIG_X(1.0308302360681956), _FIXEDPT_ZIG_X(1.0464709007640454), _FIXEDPT_ZIG_X(1.0619059636948243), _FIXEDPT_ZIG_X(1.0771506248928957),
+		_FIXEDPT_ZIG_X(1.0922188769072774), _FIXEDPT_ZIG_X(1.107123647534036), _FIXEDPT_ZIG_X(1.1218769225825422), _FIXEDPT_ZIG_X(1.1364898520131608),
+		_FIXEDPT_ZIG_X(1.1509728421488674), _FIXEDPT_ZIG_X(1.1653356361647524), _FIXEDPT_ZIG_X(1.1795873846639882), _FIXEDPT_ZIG_X(1.1937367078331287),
+		_FIXEDPT_ZIG_X(1.2077917504159497), _FIXEDPT_ZIG_X(1.2217602305399964), _FIXEDPT_ZIG_X(1.2356494832633627), _FIXEDPT_ZIG_X(1.2494664995730682),
+		_FIXEDPT_ZIG_X(1.2632179614546211), _FIXEDPT_ZIG_X(1.2769102735601556), _FIXEDPT_ZIG_X(1.2905495919261964), _FIXEDPT_ZIG_X(1.3041418501286168),
+		_FIXEDPT_ZIG_X(1.3176927832094141), _FIXEDPT_ZIG_X(1.3312079496656273), _FIXEDPT_ZIG_X(1.344692751753547), _FIXEDPT_ZIG_X(1.3581524543301435),
+		_FIXEDPT_ZIG_X(1.3715922024273426), _FIXEDPT_ZIG_X(1.3850170377326518), _FIXEDPT_ZIG_X(1.3984319141310053), _FIXEDPT_ZIG_X(1.4118417124470577),
+		_FIXEDPT_ZIG_X(1.4252512545140601), _FIXEDPT_ZIG_X(1.4386653166845635), _FIXEDPT_ZIG_X(1.4520886428892246), _FIXEDPT_ZIG_X(1.4655259573427108),
+		_FIXEDPT_ZIG_X(1.4789819769899242), _FIXEDPT_ZIG_X(1.492461423781354), _FIXEDPT_ZIG_X(1.5059690368632033), _FIXEDPT_ZIG_X(1.5195095847659401),
+		_FIXEDPT_ZIG_X(1.5330878776740433), _FIXEDPT_ZIG_X(1.5467087798599104), _FIXEDPT_ZIG_X(1.5603772223661689), _FIXEDPT_ZIG_X(1.5740982160230008),
+		_FIXEDPT_ZIG_X(1.5878768648905761), _FIXEDPT_ZIG_X(1.6017183802213781), _FIXEDPT_ZIG_X(1.615628095043161), _FIXEDPT_ZIG_X(1.6296114794706347),
+		_FIXEDPT_ZIG_X(1.6436741568628686), _FIXEDPT_ZIG_X(1.6578219209540241), _FIXEDPT_ZIG_X(1.6720607540976009), _FIXEDPT_ZIG_X(1.6863968467791681),
+		_FIXEDPT_ZIG_X(1.7008366185699169), _FIXEDPT_ZIG_X(1.7153867407136676), _FIXEDPT_ZIG_X(1.7300541605637305), _FIXEDPT_ZIG_X(1.7448461281138004),
+		_FIXEDPT_ZIG_X(1.7597702248995934), _FIXEDPT_ZIG_X(1.7748343955860695), _FIXEDPT_ZIG_X(1.7900469825998586), _FIXEDPT_ZIG_X(1.8054167642192285),
+		_FIXEDPT_ZIG_X(1.8209529965961255), _FIXEDPT_ZIG_X(1.836665460258446), _FIXEDPT_ZIG_X(1.8525645117280911), _FIXEDPT_ZIG_X(1.8686611409944887),
+		_FIXEDPT_ZIG_X(1.884967035707759), _FIXEDPT_ZIG_X(1.9014946531051511), _FIXEDPT_ZIG_X(1.9182573008645099), _FIXEDPT_ZIG_X(1.9352692282966228),
+		_FIXEDPT_ZIG_X(1.9525457295535567), _FIXEDPT_ZIG_X(1.9701032608543265), _FIXEDPT_ZIG_X(1.9879595741276199), _FIXEDPT_ZIG_X(2.0061338699634721),
+		_FIXEDPT_ZIG_X(2.0246469733773855), _FIXEDPT_ZIG_X(2.0435215366550676), _FIXEDPT_ZIG_X(2.0627822745083084), _FIXEDPT_ZIG_X(2.0824562379920168),
+		_FIXEDPT_ZIG_X(2.1025731351892385), _FIXEDPT_ZIG_X(2.1231657086739766), _FIXEDPT_ZIG_X(2.1442701823603953), _FIXEDPT_ZIG_X(2.1659267937489219),
+		_FIXEDPT_ZIG_X(2.1881804320760492), _FIXEDPT_ZIG_X(2.2110814088787034), _FIXEDPT_ZIG_X(2.2346863955909795), _FIXEDPT_ZIG_X(2.2590595738691985),
+		_FIXEDPT_ZIG_X(2.2842740596774718), _FIXEDPT_ZIG_X(2.310413683698763), _FIXEDPT_ZIG_X(2.3375752413392368), _FIXEDPT_ZIG_X(2.3658713701176386),
+		_FIXEDPT_ZIG_X(2.3954342780110625), _FIXEDPT_ZIG_X(2.4264206455337498), _FIXEDPT_ZIG_X(2.4590181774118305), _FIXEDPT_ZIG_X(2.4934545220953721),
+		_FIXEDPT_ZIG_X(2.5300096723888275), _FIXEDPT_ZIG_X(2.5690336259249378), _FIXEDPT_ZIG_X(2.6109722484318474), _FIXEDPT_ZIG_X(2.6564064112613597),
+		_FIXEDPT_ZIG_X(2.7061135731218195), _FIXEDPT_ZIG_X(2.7611693723871769), _FIXEDPT_ZIG_X(2.8231253505489105), _FIXEDPT_ZIG_X(2.8943440070215289),
+		_FIXEDPT_ZIG_X(2.9786962526477803), _FIXEDPT_ZIG_X(3.0832288582168683), _FIXEDPT_ZIG_X(3.2230849845811416), _FIXEDPT_ZIG_X(3.4426198558990002),
+	};
+	static const fixedptu K[128] = {
+		_FIXEDPT_ZIG_K(0.92715860260966809), _FIXEDPT_ZIG_K(0), _FIXEDPT_ZIG_K(0.75046102138899429), _FIXEDPT_ZIG_K(0.85071654937943442),
+		_FIXEDPT_ZIG_K(0.89341051972459762), _FIXEDPT_ZIG_K(0.91699279707169312), _FIXEDPT_ZIG_K(0.93191932674895062), _FIXEDPT_ZIG_K(0.9422042060159378),
+		_FIXEDPT_ZIG_K(0.94971534788091627), _FIXEDPT_ZIG_K(0.95543841882869618), _FIXEDPT_ZIG_K(0.95994217656590097), _FIXEDPT_ZIG_K(0.96357758631187951),
+		_FIXEDPT_ZIG_K(0.96657285378538182), _FIXEDPT_ZIG_K(0.9690827290502092), _FIXEDPT_ZIG_K(0.97121583268629852), _FIXEDPT_ZIG_K(0.97305063687522453),
+		_FIXEDPT_ZIG_K(0.97464523783007639), _FIXEDPT_ZIG_K(0.97604356093863154), _FIXEDPT_ZIG_K(0.97727942988529215), _FIXEDPT_ZIG_K(0.97837931059633121),
+		_FIXEDPT_ZIG_K(0.97936420732745055), _FIXEDPT_ZIG_K(0.98025100142276667), _FIXEDPT_ZIG_K(0.98105341485447561), _FIXEDPT_ZIG_K(0.98178271570611264),
+		_FIXEDPT_ZIG_K(0.98244824275257281), _FIXEDPT_ZIG_K(0.98305780101683371), _FIXEDPT_ZIG_K(0.98361796385447464), _FIXEDPT_ZIG_K(0.98413430634945731),
+		_FIXEDPT_ZIG_K(0.98461158757103473), _FIXEDPT_ZIG_K(0.98505389429899071), _FIXEDPT_ZIG_K(0.98546475539408995), _FIXEDPT_ZIG_K(0.98584723357553894),
+		_FIXEDPT_ZIG_K(0.98620399964423899), _FIXEDPT_ZIG_K(0.98653739294616549), _FIXEDPT_ZIG_K(0.98684947096108866), _FIXEDPT_ZIG_K(0.98714205023059953),
+		_FIXEDPT_ZIG_K(0.98741674033883642), _FIXEDPT_ZIG_K(0.98767497228253098), _FIXEDPT_ZIG_K(0.98791802228090508), _FIXEDPT_ZIG_K(0.98814703185694575),
+		_FIXEDPT_ZIG_K(0.98836302485260341), _FIXEDPT_ZIG_K(0.98856692190915973), _FIXEDPT_ZIG_K(0.98875955284124373), _FIXEDPT_ZIG_K(0.9889416672520418),
+		_FIXEDPT_ZIG_K(0.98911394367309524), _FIXEDPT_ZIG_K(0.98927699746094222), _FIXEDPT_ZIG_K(0.98943138764184679), _FIXEDPT_ZIG_K(0.98957762286281981),
+		_FIXEDPT_ZIG_K(0.98971616658035255), _FIXEDPT_ZIG_K(0.98984744159647786), _FIXEDPT_ZIG_K(0.98997183403395694), _FIXEDPT_ZIG_K(0.99008969682771364),
+		_FIXEDPT_ZIG_K(0.99020135279756305), _FIXEDPT_ZIG_K(0.99030709735723799), _FIXEDPT_ZIG_K(0.99040720090638834), _FIXEDPT_ZIG_K(0.99050191094523621),
+		_FIXEDPT_ZIG_K(0.99059145394572945), _FIXEDPT_ZIG_K(0.99067603700809548), _FIXEDPT_ZIG_K(0.9907558493275227), _FIXEDPT_ZIG_K(0.99083106349214667),
+		_FIXEDPT_ZIG_K(0.99090183663049125), _FIXEDPT_ZIG_K(0.99096831142390407), _FIXEDPT_ZIG_K(0.99103061699728945), _FIXEDPT_ZIG_K(0.99108886969948096),
+		_FIXEDPT_ZIG_K(0.99114317378289896), _FIXEDPT_ZIG_K(0.991193621990624), _FIXEDPT_ZIG_K(0.9912402960576856), _FIXEDPT_ZIG_K(0.99128326713214987),
+		_FIXEDPT_ZIG_K(0.99132259612049656), _FIXEDPT_ZIG_K(0.99135833396074968), _FIXEDPT_ZIG_K(0.99139052182587151), _FIXEDPT_ZIG_K(0.99141919125900113),
+		_FIXEDPT_ZIG_K(0.99144436424122284), _FIXEDPT_ZIG_K(0.9914660531916395), _FIXEDPT_ZIG_K(0.99148426089860509), _FIXEDPT_ZIG_K(0.99149898038000517),
+		_FIXEDPT_ZIG_K(0.99151019466943868), _FIXEDPT_ZIG_K(0.99151787652404422), _FIXEDPT_ZIG_K(0.99152198804846459), _FIXEDPT_ZIG_K(0.99152248022806455),
+		_FIXEDPT_ZIG_K(0.99151929236293068), _FIXEDPT_ZIG_K(0.9915123513923666), _FIXEDPT_ZIG_K(0.99150157109748349), _FIXEDPT_ZIG_K(0.99148685116701207),
+		_FIXEDPT_ZIG_K(0.99146807610853294), _FIXEDPT_ZIG_K(0.99144511398384472), _FIXEDPT_ZIG_K(0.9914178149430195), _FIXEDPT_ZIG_K(0.99138600952667588),
+		_FIXEDPT_ZIG_K(0.99134950669991539), _FIXEDPT_ZIG_K(0.99130809157396138), _FIXEDPT_ZIG_K(0.99126152276245516), _FIXEDPT_ZIG_K(0.99120952930818496),
+		_FIXEDPT_ZIG_K(0.99115180710216499), _FIXEDPT_ZIG_K(0.99108801469971874), _FIXEDPT_ZIG_K(0.99101776841657896), _FIXEDPT_ZIG_K(0.99094063656071807),
+		_FIXEDPT_ZIG_K(0.99085613262097194), _FIXEDPT_ZIG_K(0.99076370718921958), _FIXEDPT_ZIG_K(0.99066273833585672), _FIXEDPT_ZIG_K(0.99055252008432182),
+		_FIXEDPT_ZIG_K(0.99043224853369438), _FIXEDPT_ZIG_K(0.99030100505080254), _FIXEDPT_ZIG_K(0.99015773578346966), _FIXEDPT_ZIG_K(0.99000122651835243),
+		_FIXEDPT_ZIG_K(0.98983007159696879), _FIXEDPT_ZIG_K(0.98964263517811046), _FIXEDPT_ZIG_K(0.98943700254369094), _FIXEDPT_ZIG_K(0.98921091831302443),
+		_FIXEDPT_ZIG_K(0.98896170724285448), _FIXEDPT_ZIG_K(0.98868617156930783), _FIXEDPT_ZIG_K(0.98838045631210891), _FIXEDPT_ZIG_K(0.98803987015701755),
+		_FIXEDPT_ZIG_K(0.98765864371032963), _FIXEDPT_ZIG_K(0.98722959781119435), _FIXEDPT_ZIG_K(0.98674367998678636), _FIXEDPT_ZIG_K(0.98618930308197361),
+		_FIXEDPT_ZIG_K(0.98555137923289438), _FIXEDPT_ZIG_K(0.98480987047335344), _FIXEDPT_ZIG_K(0.98393754566633251), _FIXEDPT_ZIG_K(0.98289638112718658),
+		_FIXEDPT_ZIG_K(0.98163153152396454), _FIXEDPT_ZIG_K(0.98006069464048895), _FIXEDPT_ZIG_K(0.97805411716851776), _FIXEDPT_ZIG_K(0.97539385218210217),
+		_FIXEDPT_ZIG_K(0.97168148798278098), _FIXEDPT_ZIG_K(0.96609638454488822), _FIXEDPT_ZIG_K(0.95660799295292287), _FIXEDPT_ZIG_K(0.93623028957388921),
+	};
+	/* f(x_i) = e^(-x_i^2 / 2) */
+	static const fixedpt F[128] = {
+		fixedpt_rconst(1), fixedpt_rconst(0.96359969312708615), fixedpt_rconst(0.93628268168505957), fixedpt_rconst(0.9130436479717402),
+		fixedpt_rconst(0.8922816507840261), fixedpt_rconst(0.87324304891006954), fixedpt_rconst(0.85550060786945059), fixedpt_rconst(0.83878360529598961),
+		fixedpt_rconst(0.82290721138140899), fixedpt_rconst(0.80773829468296054), fixedpt_rconst(0.79317701177130506), fixedpt_rconst(0.7791460859296877),
+		fixedpt_rconst(0.7655841738977045), fixedpt_rconst(0.75244155917461142), fixedpt_rconst(0.73967724367264731), fixedpt_rconst(0.72725691834418482),
+		fixedpt_rconst(0.7151515074104986), fixedpt_rconst(0.70333609901615812), fixedpt_rconst(0.69178914343667508), fixedpt_rconst(0.68049184099733406),
+		fixedpt_rconst(0.66942766734889037), fixedpt_rconst(0.65858200005008805), fixedpt_rconst(0.64794182111022247), fixedpt_rconst(0.6374954773350423),
+		fixedpt_rconst(0.62723248524992725), fixedpt_rconst(0.61714337081888093), fixedpt_rconst(0.60721953662512029), fixedpt_rconst(0.59745315094451668),
+		fixedpt_rconst(0.58783705443470657), fixedpt_rconst(0.57836468111976314), fixedpt_rconst(0.56902999106795094), fixedpt_rconst(0.55982741270408687),
+		fixedpt_rconst(0.55075179311460454), fixedpt_rconst(0.5417983550254255), fixedpt_rconst(0.53296265938383613), fixedpt_rconst(0.52424057267298407),
+		fixedpt_rconst(0.51562823824400184), fixedpt_rconst(0.50712205107556896), fixedpt_rconst(0.4987186354709795), fixedpt_rconst(0.49041482528384411),
+		fixedpt_rconst(0.48220764632948521), fixedpt_rconst(0.47409430069301695), fixedpt_rconst(0.46607215268945612), fixedpt_rconst(0.45813871626787206),
+		fixedpt_rconst(0.45029164368203922), fixedpt_rconst(0.44252871527546844), fixedpt_rconst(0.43484783024999091), fixedpt_rconst(0.42724699830499607),
+		fixedpt_rconst(0.41972433204957438), fixedpt_rconst(0.412278040102661), fixedpt_rconst(0.40490642080722294), fixedpt_rconst(0.39760785649387331),
+		fixedpt_rconst(0.39038080823731458), fixedpt_rconst(0.3832238110559012), fixedpt_rconst(0.37613546951056259), fixedpt_rconst(0.36911445366447221),
+		fixedpt_rconst(0.36215949536931757), fixedpt_rconst(0.35526938484791709), fixedpt_rconst(0.34844296754632659), fixedpt_rconst(0.34167914123155041),
+		fixedpt_rconst(0.33497685331358917), fixedpt_rconst(0.3283350983728503), fixedpt_rconst(0.32175291587598492), fixedpt_rconst(0.31522938806501088),
+		fixedpt_rconst(0.30876363800618112), fixedpt_rconst(0.30235482778648354), fixedpt_rconst(0.29600215684693298), fixedpt_rconst(0.28970486044295984),
+		fixedpt_rconst(0.28346220822323298), fixedpt_rconst(0.27727350291918812), fixedpt_rconst(0.27113807913838461), fixedpt_rconst(0.26505530225558921),
+		fixedpt_rconst(0.25902456739620483), fixedpt_rconst(0.25304529850732577), fixedpt_rconst(0.24711694751232141), fixedpt_rconst(0.24123899354543982),
+		fixedpt_rconst(0.23541094226347908), fixedpt_rconst(0.22963232523211613), fixedpt_rconst(0.22390269938500842), fixedpt_rconst(0.2182216465543054),
+		fixedpt_rconst(0.2125887730717303), fixedpt_rconst(0.20700370943992652), fixedpt_rconst(0.20146611007431367), fixedpt_rconst(0.19597565311627774),
+		fixedpt_rconst(0.19053204031913715), fixedpt_rconst(0.18513499700899219), fixedpt_rconst(0.17978427212329545), fixedpt_rconst(0.1744796383307895),
+		fixedpt_rconst(0.169220892237365), fixedpt_rconst(0.16400785468342038), fixedpt_rconst(0.1588403711394793), fixedpt_rconst(0.15371831220818166),
+		fixedpt_rconst(0.14864157424234226), fixedpt_rconst(0.14361008009062776), fixedpt_rconst(0.1386237799845946), fixedpt_rconst(0.13368265258343937),
+		fixedpt_rconst(0.12878670619594321), fixedpt_rconst(0.12393598020286782), fixedpt_rconst(0.11913054670765083), fixedpt_rconst(0.11437051244886601),
+		fixedpt_rconst(0.10965602101484027), fixedpt_rconst(0.10498725540942132), fixedpt_rconst(0.10036444102865587), fixedpt_rconst(0.095787849121731439),
+		fixedpt_rconst(0.091257800826830257), fixedpt_rconst(0.086774671894780178), fixedpt_rconst(0.082338898242235656), fixedpt_rconst(0.077950982513973394),
+		fixedpt_rconst(0.073611501884113403), fixedpt_rconst(0.069321117393577908), fixedpt_rconst(0.065080585213068073), fixedpt_rconst(0.060890770348040406),
+		fixedpt_rconst(0.056752663481049848), fixedpt_rconst(0.052667401903051012), fixedpt_rconst(0.048636295859867805), fixedpt_rconst(0.044660862200491425),
+		fixedpt_rconst(0.040742868074444175), fixedpt_rconst(0.036884388786656203), fixedpt_rconst(0.033087886146225751), fixedpt_rconst(0.02935631744000685),
+		fixedpt_rconst(0.025693291935934271), fixedpt_rconst(0.022103304615927098), fixedpt_rconst(0.018592102737011288), fixedpt_rconst(0.015167298010546568),
+		fixedpt_rconst(0.011839478657884862), fixedpt_rconst(0.0086244844128598851), fixedpt_rconst(0.0055489952207713449), fixedpt_rconst(0.0026696290838809228),
+	};
+	static const fixedpt R = fixedpt_rconst(3.442619855899);
+	static const fixedpt INV_R = fixedpt_rconst(0.29047645161474317);
+	const int shift = FIXEDPT_BITS - 1 + _FIXEDPT_ZIG_XBITS - FIXEDPT_FBITS;
+
+	for (;;) {
+		uint64_t r = _fixedpt_rng_next(rng);
+		int i = (int)(r & 127);
+		fixedpt u = (fixedpt)(r >> (64 - FIXEDPT_BITS));
+		fixedptu au = (u < 0) ? -(fixedptu)u : (fixedptu)u;
+		fixedptd x;
+		fixedpt y, h, f;
+
+		if (au < K[i])
+			return ((fixedpt)(((fixedptd)u * X[i] + ((fixedptd)1 << (shift - 1))) >> shift));
+
+		if (i == 0) {
+			/* The tail beyond r, by Marsaglia's method */
+			do {
+				r = _fixedpt_rng_next(rng);
+				x = fixedpt_mul(_fixedpt_rng_neglog((uint32_t)(r >> 33)), INV_R);
+				y = _fixedpt_rng_neglog((uint32_t)r >> 1);
+			} while (((fixedptd)y << (FIXEDPT_FBITS + 1)) < x * x);
+			return ((u < 0) ? -(R + (fixedpt)x) : R + (fixedpt)x);
+		}
+
+		/* The wedge: accept under the curve between f(x_i) and f(x_(i-1)) */
+		x = ((fixedptd)u * X[i]) >> (FIXEDPT_BITS - 1);
+		h = (fixedpt)((x * x) >> (2 * _FIXEDPT_ZIG_XBITS + 1 - FIXEDPT_FBITS));
+		f = (fixedpt)(_fixedpt_rng_next(rng) >> (64 - FIXEDPT_FBITS));
+		if (F[i] + fixedpt_mul(f, F[i - 1] - F[i]) < _fixedpt_exp_neg((fixedptu)h))
+			return ((fixedpt)((x + ((fixedptd)1 << (_FIXEDPT_ZIG_XBITS - FIXEDPT_FBITS - 1))) >>
+			    (_FIXEDPT_ZIG_XBITS - FIXEDPT_FBITS)));
+	}
+}
+#endif
+
+/*
+ * Oscillators.
+ *
+ * An angle in radians becomes a phase in 2^-128 turns, as two words, which
+ * wraps around by itself, so the phase of every sample is exact up to the
+ * rounding of freq to 2^-128 turns: after 2^48 samples it is off by less
+ * than 2^-80 turns, well below an LSB of any format, where 2^-64 turns
+ * let Q8.56 drift by an LSB in under a hundred samples. The sines are
+ * taken at the phase rounded to 2^-64 turns, which does not add up from
+ * sample to sample. Each block of FIXEDPT_NCO_LANES samples is the previous one
+ * rotated by a complex multiply with _FIXEDPT_PBITS fraction bits, which
+ * rounds by half a unit per component and step. Every _FIXEDPT_NCO_SPAN
+ * blocks the block is recomputed from the phase with the sin and cos
+ * polynomials, which resets that error before it reaches the fixedpt
+ * result, and the magnitude with it.
+ */
+#define _FIXEDPT_NCO_GUARD	(_FIXEDPT_PBITS - FIXEDPT_FBITS)
+#if _FIXEDPT_NCO_GUARD >= 14
+#define _FIXEDPT_NCO_SPAN	1024
+#elif _FIXEDPT_NCO_GUARD > 4
+#define _FIXEDPT_NCO_SPAN	(1 << (_FIXEDPT_NCO_GUARD - 4))
+#else
+#define _FIXEDPT_NCO_SPAN	1
+#endif
+
+/* Returns the high word of the 128-bit a * b, and sets *lo to the low word */
+_FIXEDPT_INLINE uint64_t _fixedpt_nco_mul(uint64_t a, uint64_t b, uint64_t *lo)
+{
+	uint64_t a0 = a & 0xffffffff, a1 = a >> 32;
+	uint64_t b0 = b & 0xffffffff, b1 = b >> 32;
+	uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0;
+	uint64_t mid = (p00 >> 32) + (p01 & 0xffffffff) + (p10 & 0xffffffff);
+
+	*lo = (mid << 32) | (p00 & 0xffffffff);
+	return (a1 * b1 + (p01 >> 32) + (p10 >> 32) + (mid >> 32));
+}
+
+/*
+ * Returns the angle a in 2^-64 turns and sets *lo to the next 64 bits,
+ * rounded to 2^-128 turns and modulo one turn.
+ */
+_FIXEDPT_INLINE uint64_t _fixedpt_nco_turns(fixedpt a, uint64_t *lo)
+{
+	/* 2^128 / (2 pi) */
+	const uint64_t k1 = 0x28be60db9391054aULL, k0 = 0x7f09d5f47d4d3770ULL;
+	uint64_t m = (a < 0) ? -(uint64_t)a : (uint64_t)a;
+	uint64_t w0, w1, w2, p, h, l;
+
+	/* The 192-bit m * k, w2:w1:w0, has FIXEDPT_FBITS fraction bits */
+	w1 = _fixedpt_nco_mul(m, k0, &w0);
+	w2 = _fixedpt_nco_mul(m, k1, &p);
+	w1 += p;
+	w2 += (w1 < p);
+	l = (w1 << (64 - FIXEDPT_FBITS)) | (w0 >> FIXEDPT_FBITS);
+	h = (w2 << (64 - FIXEDPT_FBITS)) | (w1 >> FIXEDPT_FBITS);
+	p = (w0 >> (FIXEDPT_FBITS - 1)) & 1;
+	l += p;
+	h += (l < p);
+	if (a < 0) {
+		h = ~h + (l == 0);
+		l = -l;
+	}
+	*lo = l;
+	return (h);
+}
+
+/* Returns phase + n * freq in 2^-64 turns, and sets *lo to the next 64 bits */
+_FIXEDPT_INLINE uint64_t _fixedpt_nco_step(uint64_t phase, uint64_t phase_lo,
+    uint64_t freq, uint64_t freq_lo, uint64_t n, uint64_t *lo)
+{
+	uint64_t l, h = _fixedpt_nco_mul(n, freq_lo, &l);
+
+	*lo = phase_lo + l;
+	return (phase + n * freq + h + (*lo < l));
+}
+
+/* Sets *s and *c to the sine and cosine of the phase u, with _FIXEDPT_PBITS fraction bits */
+_FIXEDPT_INLINE void _fixedpt_nco_sincos(uint64_t u, _fixedpt_p *s, _fixedpt_p *c)
+{
+	const uint64_t half = (uint64_t)1 << 63, quarter = (uint64_t)1 << 62;
+	const int shift = 62 - _FIXEDPT_PBITS;
+	int flip = 0;
+	_fixedpt_p t, cp;
+
+	/* Reflect [pi/2, 3pi/2) into (-pi/2, pi/2], then t = angle * 2/pi */
+	if (u - quarter < half) {
+		u = half - u;
+		flip = 1;
+	}
+	t = (_fixedpt_p)(((int64_t)u + (((int64_t)1 << shift) >> 1)) >> shift);
+	_fixedpt_sincos_p(t, s, &cp);
+	*c = flip ? -cp : cp;
+}
+
+/* Rotates (*c, *s) by (wc, ws), all with _FIXEDPT_PBITS fraction bits */
+_FIXEDPT_INLINE void _fixedpt_nco_rotate(_fixedpt_p *s, _fixedpt_p *c, _fixedpt_p ws, _fixedpt_p wc)
+{
+	const _fixedpt_pd half = ((_fixedpt_pd)1 << _FIXEDPT_PBITS) >> 1;
+	_fixedpt_pd sn = (_fixedpt_pd)*s * wc + (_fixedpt_pd)*c * ws;
+	_fixedpt_pd cn = (_fixedpt_pd)*c * wc - (_fixedpt_pd)*s * ws;
+
+	*s = (_fixedpt_p)((sn + half) >> _FIXEDPT_PBITS);
+	*c = (_fixedpt_p)((cn + half) >> _FIXEDPT_PBITS);
+}
+
+/* Computes the block of samples at phase + j * freq from the phase */
+_FIXEDPT_INLINE void _fixedpt_nco_block(_fixedpt_p *s, _fixedpt_p *c, uint64_t phase, uint64_t phase_lo,
+    uint64_t freq, uint64_t freq_lo)
+{
+	uint64_t u, lo;
+	int j;
+
+	for (j = 0; j < FIXEDPT_NCO_LANES; j++) {
+		u = _fixedpt_nco_step(phase, phase_lo, freq, freq_lo, (uint64_t)j, &lo);
+		_fixedpt_nco_sincos(u + (lo >> 63), &s[j], &c[j]);
+	}
+}
+
+/* Moves to the next block of samples, rotating it or recomputing it */
+_FIXEDPT_INLINE void _fixedpt_nco_advance(_fixedpt_p *s, _fixedpt_p *c, _fixedpt_p ws, _fixedpt_p wc,
+    uint64_t *phase, uint64_t *phase_lo, uint64_t freq, uint64_t freq_lo, unsigned int *left)
+{
+	int j;
+
+	*phase = _fixedpt_nco_step(*phase, *phase_lo, freq, freq_lo, FIXEDPT_NCO_LANES, phase_lo);
+	if (*left == 0) {
+		_fixedpt_nco_block(s, c, *phase, *phase_lo, freq, freq_lo);
+		*left = _FIXEDPT_NCO_SPAN - 1;
+	} else {
+		for (j = 0; j < FIXEDPT_NCO_LANES; j++)
+			_fixedpt_nco_rotate(&s[j], &c[j], ws, wc);
+		(*left)--;
+	}
+}
+
+/*
+ * Advances nblk blocks, writing each into s and c, either of which may
+ * be NULL. The state is copied into locals so that it cannot alias the
+ * outputs.
+ */
+_FIXEDPT_INLINE void _fixedpt_nco_kernel(fixedpt_nco *nco, fixedpt *so, fixedpt *co, size_t nblk)
+{
+	_fixedpt_p s[FIXEDPT_NCO_LANES], c[FIXEDPT_NCO_LANES];
+	const _fixedpt_p ws = nco->ws, wc = nco->wc;
+	const uint64_t freq = nco->freq, freq_lo = nco->freq_lo;
+	uint64_t phase = nco->phase, phase_lo = nco->phase_lo;
+	unsigned int left = nco->left;
+	size_t b;
+	int j;
+
+	for (j = 0; j < FIXEDPT_NCO_LANES; j++) {
+		s[j] = nco->s[j];
+		c[j] = nco->c[j];
+	}
+	for (b = 0; b < nblk; b++) {
+		_fixedpt_nco_advance(s, c, ws, wc, &phase, &phase_lo, freq, freq_lo, &left);
+		if (so != NULL)
+			for (j = 0; j < FIXEDPT_NCO_LANES; j++)
+				so[b * FIXEDPT_NCO_LANES + j] = _fixedpt_pround(s[j]);
+		if (co != NULL)
+			for (j = 0; j < FIXEDPT_NCO_LANES; j++)
+				co[b * FIXEDPT_NCO_LANES + j] = _fixedpt_pround(c[j]);
+	}
+	for (j = 0; j < FIXEDPT_NCO_LANES; j++) {
+		nco->s[j] = s[j];
+		nco->c[j] = c[j];
+	}
+	nco->phase = phase;
+	nco->phase_lo = phase_lo;
+	nco->left = left;
+}
+
+/*
+ * Batch kernels and run-time dispatch.
+ *
+ * Every batch entry point goes through a table of kernel pointers. Each
+ * kernel is written once as an inline loop; on x86 with GCC or clang it
+ * is also compiled for AVX2 and for AVX-512 through target attributes,
+ * so the compiler vectorizes the same loop at each width, at -O2 as well
+ * as -O3 (the scalar form is vectorized only at -O3). The table is
+ * chosen from CPUID on first use, or explicitly by fixedpt_dispatch_init()
+ * at startup, and fixedpt_dispatch_force() pins a path, e.g. to test the
+ * scalar fallback on an AVX-512 host. Kernels that are loops over
+ * fixedpt_sin and friends gain nothing from a wider target and only
+ * exist in scalar form. Defining FIXEDPT_NO_DISPATCH builds the scalar
+ * path only.
+ *
+ * In 16-bit builds the AVX2 and AVX-512 forms of the multiply kernels
+ * work on 16 and 32 lanes per instruction; with FIXEDPT_WBITS=1 (Q1.15)
+ * each lane is a single pmulhrsw.
+ */
+
+_FIXEDPT_INLINE void _fixedpt_mul_kernel(const fixedpt *a, const fixedpt *b, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = fixedpt_mul(a[i], b[i]);
+}
+
+_FIXEDPT_INLINE void _fixedpt_scale_kernel(const fixedpt *in, fixedpt k, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = fixedpt_mul(in[i], k);
+}
+
+_FIXEDPT_INLINE void _fixedpt_sigmoid_kernel(const fixedpt *in, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = _fixedpt_sigmoid(in[i]);
+}
+
+_FIXEDPT_INLINE void _fixedpt_tanh_kernel(const fixedpt *in, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = _fixedpt_tanh(in[i]);
+}
+
+_FIXEDPT_INLINE void _fixedpt_gelu_kernel(const fixedpt *in, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = _fixedpt_gelu(in[i]);
+}
+
+_FIXEDPT_INLINE void _fixedpt_atan_kernel(const fixedpt *in, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = _fixedpt_atan(in[i]);
+}
+
+_FIXEDPT_INLINE void _fixedpt_atan2_kernel(const fixedpt *y, const fixedpt *x, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = _fixedpt_pround(_fixedpt_atan2_p(y[i], x[i]));
+}
+
+_FIXEDPT_INLINE void _fixedpt_cmul_kernel(const fixedpt_complex *a, const fixedpt_complex *b,
+    fixedpt_complex *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = _fixedpt_cmul(a[i].re, a[i].im, b[i].re, b[i].im);
+}
+
+_FIXEDPT_INLINE void _fixedpt_cmul_split_kernel(const fixedpt *are, const fixedpt *aim,
+    const fixedpt *bre, const fixedpt *bim, fixedpt *re, fixedpt *im, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		fixedpt_complex r = _fixedpt_cmul(are[i], aim[i], bre[i], bim[i]);
+
+		re[i] = r.re;
+		im[i] = r.im;
+	}
+}
+
+_FIXEDPT_INLINE void _fixedpt_cabs_kernel(const fixedpt_complex *in, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = _fixedpt_cabs(in[i].re, in[i].im);
+}
+
+_FIXEDPT_INLINE void _fixedpt_cabs_split_kernel(const fixedpt *re, const fixedpt *im, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = _fixedpt_cabs(re[i], im[i]);
+}
+
+/* Loops over the scalar functions, which do not vectorize */
+static void _fixedpt_sqrt_scalar(const fixedpt *in, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = fixedpt_sqrt(in[i]);
+}
+
+static void _fixedpt_exp_scalar(const fixedpt *in, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = fixedpt_exp(in[i]);
+}
+
+static void _fixedpt_ln_scalar(const fixedpt *in, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = fixedpt_ln(in[i]);
+}
+
+static void _fixedpt_sin_scalar(const fixedpt *in, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = fixedpt_sin(in[i]);
+}
+
+static void _fixedpt_cos_scalar(const fixedpt *in, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = fixedpt_cos(in[i]);
+}
+
+/* Instantiates _fixedpt_<name>_<isa> for each instruction set path */
+#ifdef _FIXEDPT_X86_DISPATCH
+/*
+ * GCC before 12 does not vectorize at -O2, and from 12 on does so only
+ * under the very-cheap cost model, which rejects every kernel here; the
+ * wide variants turn the vectorizer on themselves. Clang vectorizes at
+ * -O2 and warns on the optimize attribute.
+ */
+#ifdef __clang__
+#define _FIXEDPT_TARGET(isa)	__attribute__((target(isa)))
+#else
+#define _FIXEDPT_TARGET(isa)	__attribute__((target(isa), optimize("tree-vectorize")))
+#endif
+#define _FIXEDPT_TARGET_AVX2	_FIXEDPT_TARGET("avx2,bmi2")
+#define _FIXEDPT_TARGET_AVX512	_FIXEDPT_TARGET("avx2,bmi2,avx512f,avx512bw,avx512dq,avx512vl")
+#define _FIXEDPT_VARIANTS(name, params, args)				\
+	static void _fixedpt_##name##_scalar params			\
+	{ _fixedpt_##name##_kernel args; }				\
+	_FIXEDPT_TARGET_AVX2 static void _fixedpt_##name##_avx2 params	\
+	{ _fixedpt_##name##_kernel args; }				\
+	_FIXEDPT_TARGET_AVX512 static void _fixedpt_##name##_avx512 params \
+	{ _fixedpt_##name##_kernel args; }
+#else
+#define _FIXEDPT_VARIANTS(name, params, args)				\
+	static void _fixedpt_##name##_scalar params			\
+	{ _fixedpt_##name##_kernel args; }
+#endif
+
+_FIXEDPT_VARIANTS(mul, (const fixedpt *a, const fixedpt *b, fixedpt *out, size_t n), (a, b, out, n))
+_FIXEDPT_VARIANTS(scale, (const fixedpt *in, fixedpt k, fixedpt *out, size_t n), (in, k, out, n))
+_FIXEDPT_VARIANTS(sigmoid, (const fixedpt *in, fixedpt *out, size_t n), (in, out, n))
+_FIXEDPT_VARIANTS(tanh, (const fixedpt *in, fixedpt *out, size_t n), (in, out, n))
+_FIXEDPT_VARIANTS(gelu, (const fixedpt *in, fixedpt *out, size_t n), (in, out, n))
+_FIXEDPT_VARIANTS(atan, (const fixedpt *in, fixedpt *out, size_t n), (in, out, n))
+_FIXEDPT_VARIANTS(atan2, (const fixedpt *y, const fixedpt *x, fixedpt *out, size_t n), (y, x, out, n))
+_FIXEDPT_VARIANTS(softmax, (const fixedpt *in, fixedpt *out, size_t n), (in, out, n))
+_FIXEDPT_VARIANTS(unpack, (const uint64_t *blk, int width, int mode, fixedpt *out), (blk, width, mode, out))
+_FIXEDPT_VARIANTS(sum, (const fixedpt *in, size_t n, fixedpt_acc *sum), (in, n, sum))
+_FIXEDPT_VARIANTS(moments, (const fixedpt *in, size_t n, fixedpt_stats *s), (in, n, s))
+_FIXEDPT_VARIANTS(minmax, (const fixedpt *in, size_t n, fixedpt *min, fixedpt *max), (in, n, min, max))
+_FIXEDPT_VARIANTS(hist, (const fixedpt *in, size_t n, const struct _fixedpt_bins *b, fixedptu *idx), (in, n, b, idx))
+_FIXEDPT_VARIANTS(lut, (const fixedpt_lut *lut, const fixedpt *in, fixedpt *out, size_t n, size_t *hint),
+    (lut, in, out, n, hint))
+_FIXEDPT_VARIANTS(lut2, (const fixedpt_lut2 *lut, const fixedpt *x, const fixedpt *y, fixedpt *out, size_t n,
+    size_t *hint), (lut, x, y, out, n, hint))
+_FIXEDPT_VARIANTS(cmul, (const fixedpt_complex *a, const fixedpt_complex *b, fixedpt_complex *out, size_t n),
+    (a, b, out, n))
+_FIXEDPT_VARIANTS(cmul_split, (const fixedpt *are, const fixedpt *aim, const fixedpt *bre, const fixedpt *bim,
+    fixedpt *re, fixedpt *im, size_t n), (are, aim, bre, bim, re, im, n))
+_FIXEDPT_VARIANTS(cabs, (const fixedpt_complex *in, fixedpt *out, size_t n), (in, out, n))
+_FIXEDPT_VARIANTS(cabs_split, (const fixedpt *re, const fixedpt *im, fixedpt *out, size_t n), (re, im, out, n))
+_FIXEDPT_VARIANTS(rng, (fixedpt_rng *rng, fixedpt *out, size_t nblk, int kind, fixedpt lo, fixedptu w),
+    (rng, out, nblk, kind, lo, w))
+_FIXEDPT_VARIANTS(nco, (fixedpt_nco *nco, fixedpt *s, fixedpt *c, size_t nblk), (nco, s, c, nblk))
+#ifndef FIXEDPT_NO_FLOAT
+_FIXEDPT_VARIANTS(from_float, (const float *in, fixedpt *out, size_t n, int round, size_t *nsat), (in, out, n, round, nsat))
+_FIXEDPT_VARIANTS(from_double, (const double *in, fixedpt *out, size_t n, int round, size_t *nsat), (in, out, n, round, nsat))
+_FIXEDPT_VARIANTS(to_float, (const fixedpt *in, float *out, size_t n), (in, out, n))
+_FIXEDPT_VARIANTS(to_double, (const fixedpt *in, double *out, size_t n), (in, out, n))
+#endif
+
+struct _fixedpt_kernel_table {
+	void (*mul)(const fixedpt *, const fixedpt *, fixedpt *, size_t);
+	void (*scale)(const fixedpt *, fixedpt, fixedpt *, size_t);
+	void (*sqrt)(const fixedpt *, fixedpt *, size_t);
+	void (*exp)(const fixedpt *, fixedpt *, size_t);
+	void (*ln)(const fixedpt *, fixedpt *, size_t);
+	void (*sin)(const fixedpt *, fixedpt *, size_t);
+	void (*cos)(const fixedpt *, fixedpt *, size_t);
+	void (*atan)(const fixedpt *, fixedpt *, size_t);
+	void (*atan2)(const fixedpt *, const fixedpt *, fixedpt *, size_t);
+	void (*sigmoid)(const fixedpt *, fixedpt *, size_t);
+	void (*tanh)(const fixedpt *, fixedpt *, size_t);
+	void (*gelu)(const fixedpt *, fixedpt *, size_t);
+	void (*softmax)(const fixedpt *, fixedpt *, size_t);
+	void (*unpack)(const uint64_t *, int, int, fixedpt *);
+	void (*sum)(const fixedpt *, size_t, fixedpt_acc *);
+	void (*moments)(const fixedpt *, size_t, fixedpt_stats *);
+	void (*minmax)(const fixedpt *, size_t, fixedpt *, fixedpt *);
+	void (*hist)(const fixedpt *, size_t, const struct _fixedpt_bins *, fixedptu *);
+	void (*lut)(const fixedpt_lut *, const fixedpt *, fixedpt *, size_t, size_t *);
+	void (*lut2)(const fixedpt_lut2 *, const fixedpt *, const fixedpt *, fixedpt *, size_t, size_t *);
+	void (*cmul)(const fixedpt_complex *, const fixedpt_complex *, fixedpt_complex *, size_t);
+	void (*cmul_split)(const fixedpt *, const fixedpt *, const fixedpt *, const fixedpt *,
+	    fixedpt *, fixedpt *, size_t);
+	void (*cabs)(const fixedpt_complex *, fixedpt *, size_t);
+	void (*cabs_split)(const fixedpt *, const fixedpt *, fixedpt *, size_t);
+	void (*rng)(fixedpt_rng *, fixedpt *, size_t, int, fixedpt, fixedptu);
+	void (*nco)(fixedpt_nco *, fixedpt *, fixedpt *, size_t);
+#ifndef FIXEDPT_NO_FLOAT
+	void (*from_float)(const float *, fixedpt *, size_t, int, size_t *);
+	void (*from_double)(const double *, fixedpt *, size_t, int, size_t *);
+	void (*to_float)(const fixedpt *, float *, size_t);
+	void (*to_double)(const fixedpt *, double *, size_t);
+#endif
+};
+
+#ifdef FIXEDPT_NO_FLOAT
+#define _FIXEDPT_KERNEL_TABLE(isa) {					\
+	_fixedpt_mul_##isa, _fixedpt_scale_##isa, _fixedpt_sqrt_scalar,	\
+	_fixedpt_exp_scalar,						\
+	_fixedpt_ln_scalar, _fixedpt_sin_scalar, _fixedpt_cos_scalar,	\
+	_fixedpt_atan_##isa, _fixedpt_atan2_##isa,			\
+	_fixedpt_sigmoid_##isa, _fixedpt_tanh_##isa, _fixedpt_gelu_##isa, \
+	_fixedpt_softmax_##isa, _fixedpt_unpack_##isa,			\
+	_fixedpt_sum_##isa, _fixedpt_moments_##isa, _fixedpt_minmax_##isa, \
+	_fixedpt_hist_##isa, _fixedpt_lut_##isa, _fixedpt_lut2_##isa,	\
+	_fixedpt_cmul_##isa, _fixedpt_cmul_split_##isa,			\
+	_fixedpt_cabs_##isa, _fixedpt_cabs_split_##isa, _fixedpt_rng_##isa, \
+	_fixedpt_nco_##isa }
+#else
+#define _FIXEDPT_KERNEL_TABLE(isa) {					\
+	_fixedpt_mul_##isa, _fixedpt_scale_##isa, _fixedpt_sqrt_scalar,	\
+	_fixedpt_exp_scalar,						\
+	_fixedpt_ln_scalar, _fixedpt_sin_scalar, _fixedpt_cos_scalar,	\
+	_fixedpt_atan_##isa, _fixedpt_atan2_##isa,			\
+	_fixedpt_sigmoid_##isa, _fixedpt_tanh_##isa, _fixedpt_gelu_##isa, \
+	_fixedpt_softmax_##isa, _fixedpt_unpack_##isa,			\
+	_fixedpt_sum_##isa, _fixedpt_moments_##isa, _fixedpt_minmax_##isa, \
+	_fixedpt_hist_##isa, _fixedpt_lut_##isa, _fixedpt_lut2_##isa,	\
+	_fixedpt_cmul_##isa, _fixedpt_cmul_split_##isa,			\
+	_fixedpt_cabs_##isa, _fixedpt_cabs_split_##isa, _fixedpt_rng_##isa, \
+	_fixedpt_nco_##isa, _fixedpt_from_float_##isa,					\
+	_fixedpt_from_double_##isa, _fixedpt_to_float_##isa,		\
+	_fixedpt_to_double_##isa }
+#endif
+
+static const struct _fixedpt_kernel_table _fixedpt_kernels[] = {
+	_FIXEDPT_KERNEL_TABLE(scalar),
+#ifdef _FIXEDPT_X86_DISPATCH
+	_FIXEDPT_KERNEL_TABLE(avx2),
+	_FIXEDPT_KERNEL_TABLE(avx512),
+#endif
+};
+
+/*
+ * The selected table, NULL until the first call. Its index is the
+ * FIXEDPT_ISA_* path, so that a reader never sees a path and a table
+ * that disagree. Concurrent first calls may both run the detection and
+ * store the same pointer; the accesses are atomic so that this is not
+ * a data race.
+ */
+static const struct _fixedpt_kernel_table *_fixedpt_kernels_sel = NULL;
+
+#ifdef __GNUC__
+#define _FIXEDPT_SEL_LOAD()	__atomic_load_n(&_fixedpt_kernels_sel, __ATOMIC_ACQUIRE)
+#define _FIXEDPT_SEL_STORE(t)	__atomic_store_n(&_fixedpt_kernels_sel, (t), __ATOMIC_RELEASE)
+#else
+#define _FIXEDPT_SEL_LOAD()	(_fixedpt_kernels_sel)
+#define _FIXEDPT_SEL_STORE(t)	(_fixedpt_kernels_sel = (t))
+#endif
+
+/* Returns the widest instruction set path this CPU can run */
+static int _fixedpt_isa_detect(void)
+{
+#ifdef _FIXEDPT_X86_DISPATCH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+	    __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl") &&
+	    __builtin_cpu_supports("bmi2"))
+		return (FIXEDPT_ISA_AVX512);
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2"))
+		return (FIXEDPT_ISA_AVX2);
+#endif
+	return (FIXEDPT_ISA_SCALAR);
+}
+
+/*
+ * Selects the given FIXEDPT_ISA_* path for all batch kernels. Returns 0,
+ * or -1 (leaving the selection unchanged) if this build or CPU cannot
+ * run it.
+ */
+_FIXEDPT_FUNCTYPE int fixedpt_dispatch_force(int isa)
+{
+	if (isa < FIXEDPT_ISA_SCALAR || isa > _fixedpt_isa_detect())
+		return (-1);
+	_FIXEDPT_SEL_STORE(&_fixedpt_kernels[isa]);
+	return (0);
+}
+
+/* Selects the widest path the CPU supports, returns its FIXEDPT_ISA_* */
+_FIXEDPT_FUNCTYPE int fixedpt_dispatch_init(void)
+{
+	int isa = _fixedpt_isa_detect();
+
+	fixedpt_dispatch_force(isa);
+	return (isa);
+}
+
+_FIXEDPT_INLINE const struct _fixedpt_kernel_table *_fixedpt_dispatch(void)
+{
+	const struct _fixedpt_kernel_table *t = _FIXEDPT_SEL_LOAD();
+
+	if (t == NULL) {
+		fixedpt_dispatch_init();
+		t = _FIXEDPT_SEL_LOAD();
+	}
+	return (t);
+}
+
+/* Returns the FIXEDPT_ISA_* path currently used by the batch kernels */
+_FIXEDPT_FUNCTYPE int fixedpt_dispatch_isa(void)
+{
+	return ((int)(_fixedpt_dispatch() - _fixedpt_kernels));
+}
+
+/* Multiplies n pairs of fixedpt numbers */
+_FIXEDPT_FUNCTYPE void fixedpt_mul_batch(const fixedpt *a, const fixedpt *b, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->mul(a, b, out, n);
+}
+
+/* Multiplies n fixedpt numbers by the constant k */
+_FIXEDPT_FUNCTYPE void fixedpt_scale_batch(const fixedpt *in, fixedpt k, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->scale(in, k, out, n);
+}
+
+/* Applies fixedpt_sqrt to n elements */
+_FIXEDPT_FUNCTYPE void fixedpt_sqrt_batch(const fixedpt *in, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->sqrt(in, out, n);
+}
+
+/* Applies fixedpt_exp to n elements */
+_FIXEDPT_FUNCTYPE void fixedpt_exp_batch(const fixedpt *in, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->exp(in, out, n);
+}
+
+/* Applies fixedpt_ln to n elements */
+_FIXEDPT_FUNCTYPE void fixedpt_ln_batch(const fixedpt *in, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->ln(in, out, n);
+}
+
+/* Applies fixedpt_sin to n elements */
+_FIXEDPT_FUNCTYPE void fixedpt_sin_batch(const fixedpt *in, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->sin(in, out, n);
+}
+
+/* Applies fixedpt_cos to n elements */
+_FIXEDPT_FUNCTYPE void fixedpt_cos_batch(const fixedpt *in, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->cos(in, out, n);
+}
+
+/* Applies fixedpt_atan to n elements */
+_FIXEDPT_FUNCTYPE void fixedpt_atan_batch(const fixedpt *in, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->atan(in, out, n);
+}
+
+/* Computes out[i] = fixedpt_atan2(y[i], x[i]) for n elements */
+_FIXEDPT_FUNCTYPE void fixedpt_atan2_batch(const fixedpt *y, const fixedpt *x, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->atan2(y, x, out, n);
+}
+
+/* Applies fixedpt_sigmoid to n elements */
+_FIXEDPT_FUNCTYPE void fixedpt_sigmoid_batch(const fixedpt *in, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->sigmoid(in, out, n);
+}
+
+/* Applies fixedpt_tanh to n elements */
+_FIXEDPT_FUNCTYPE void fixedpt_tanh_batch(const fixedpt *in, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->tanh(in, out, n);
+}
+
+/* Applies fixedpt_gelu to n elements */
+_FIXEDPT_FUNCTYPE void fixedpt_gelu_batch(const fixedpt *in, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->gelu(in, out, n);
+}
+
+/*
+ * Computes the softmax of n elements. The maximum is subtracted first so
+ * every exponential lies in (0, 1], the sum is kept in a fixedptd and the
+ * normalization uses a single reciprocal with 2 * FIXEDPT_BITS - 2
+ * fraction bits, so large n does not cost precision.
+ */
+_FIXEDPT_FUNCTYPE void fixedpt_softmax(const fixedpt *in, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->softmax(in, out, n);
+}
+
+#ifndef FIXEDPT_NO_FLOAT
+/* Converts n floats to fixedpt, returns the number of saturated elements */
+_FIXEDPT_FUNCTYPE size_t fixedpt_from_float_array(const float *in, fixedpt *out, size_t n, int round)
+{
+	size_t nsat;
+
+	_fixedpt_dispatch()->from_float(in, out, n, round, &nsat);
+	_FIXEDPT_CHECK_N(nsat, FIXEDPT_FN_CONVERT, FIXEDPT_ERR_SATURATE);
+	return (nsat);
+}
+
+/* Converts n doubles to fixedpt, returns the number of saturated elements */
+_FIXEDPT_FUNCTYPE size_t fixedpt_from_double_array(const double *in, fixedpt *out, size_t n, int round)
+{
+	size_t nsat;
+
+	_fixedpt_dispatch()->from_double(in, out, n, round, &nsat);
+	_FIXEDPT_CHECK_N(nsat, FIXEDPT_FN_CONVERT, FIXEDPT_ERR_SATURATE);
+	return (nsat);
+}
+
+/* Converts n fixedpt numbers to float */
+_FIXEDPT_FUNCTYPE void fixedpt_to_float_array(const fixedpt *in, float *out, size_t n)
+{
+	_fixedpt_dispatch()->to_float(in, out, n);
+}
+
+/* Converts n fixedpt numbers to double */
+_FIXEDPT_FUNCTYPE void fixedpt_to_double_array(const fixedpt *in, double *out, size_t n)
+{
+	_fixedpt_dispatch()->to_double(in, out, n);
+}
+#endif
+
+/*
+ * Returns the bytes fixedpt_pack() needs for n elements of width bits,
+ * or 0 if width is not in 1..FIXEDPT_BITS or mode is unknown. The buffer
+ * must be aligned for uint64_t.
+ */
+_FIXEDPT_FUNCTYPE size_t fixedpt_pack_size(size_t n, int width, int mode)
+{
+	size_t blocks = (n + FIXEDPT_PACK_BLOCK - 1) / FIXEDPT_PACK_BLOCK;
+
+	if (!_FIXEDPT_PACK_VALID(width, mode))
+		return (0);
+	/* One guard word after the last block */
+	return ((blocks * (size_t)(_FIXEDPT_PACK_HEAD(mode) + width) + 1) * sizeof(uint64_t));
+}
+
+/*
+ * Packs n elements into width-bit fields. FIXEDPT_PACK_PLAIN saturates
+ * values outside the signed field, FIXEDPT_PACK_OFFSET stores the distance
+ * from the block minimum and saturates distances that do not fit, and
+ * FIXEDPT_PACK_EXPONENT drops as many low bits, rounding, as the largest
+ * magnitude of the block needs, so it never saturates but loses precision.
+ * Returns the number of saturated elements, or 0 without writing anything
+ * if width or mode is invalid, as fixedpt_pack_size() returns 0 for them.
+ */
+_FIXEDPT_FUNCTYPE size_t fixedpt_pack(const fixedpt *in, size_t n, int width, int mode, uint64_t *packed)
+{
+	const size_t stride = (size_t)(_FIXEDPT_PACK_HEAD(mode) + width);
+	size_t i, nsat = 0;
+
+	if (!_FIXEDPT_PACK_VALID(width, mode))
+		return (0);
+	for (i = 0; i < n; i += FIXEDPT_PACK_BLOCK) {
+		size_t len = (n - i < FIXEDPT_PACK_BLOCK) ? n - i : FIXEDPT_PACK_BLOCK;
+
+		nsat += _fixedpt_pack_block(in + i, len, width, mode, packed);
+		packed += stride;
+	}
+	*packed = 0;
+	_FIXEDPT_CHECK_N(nsat, FIXEDPT_FN_PACK, FIXEDPT_ERR_SATURATE);
+	return (nsat);
+}
+
+/* Returns element i of a packed array, or 0 if width or mode is invalid */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_unpack_at(const uint64_t *packed, size_t i, int width, int mode)
+{
+	const uint64_t *blk = packed + (i / FIXEDPT_PACK_BLOCK) *
+	    (size_t)(_FIXEDPT_PACK_HEAD(mode) + width);
+	uint64_t f;
+
+	if (!_FIXEDPT_PACK_VALID(width, mode))
+		return (0);
+	f = _fixedpt_pack_field(blk + _FIXEDPT_PACK_HEAD(mode),
+	    (i % FIXEDPT_PACK_BLOCK) * (size_t)width) << (64 - width);
+	if (mode == FIXEDPT_PACK_OFFSET)
+		return ((fixedpt)(blk[0] + (f >> (64 - width))));
+	return ((fixedpt)((uint64_t)((int64_t)f >> (64 - width)) <<
+	    (mode == FIXEDPT_PACK_EXPONENT ? (int)blk[0] : 0)));
+}
+
+/*
+ * Unpacks elements first to first + n - 1 of a packed array. Nothing is
+ * written if width or mode is invalid.
+ */
+_FIXEDPT_FUNCTYPE void fixedpt_unpack(const uint64_t *packed, size_t first, size_t n, int width, int mode, fixedpt *out)
+{
+	const struct _fixedpt_kernel_table *k = _fixedpt_dispatch();
+	const size_t stride = (size_t)(_FIXEDPT_PACK_HEAD(mode) + width);
+	fixedpt tmp[FIXEDPT_PACK_BLOCK];
+	size_t i, j, len;
+
+	if (!_FIXEDPT_PACK_VALID(width, mode))
+		return;
+	for (i = first; i < first + n; i += len, out += len) {
+		j = i % FIXEDPT_PACK_BLOCK;
+		len = FIXEDPT_PACK_BLOCK - j;
+		if (len > first + n - i)
+			len = first + n - i;
+		if (len == FIXEDPT_PACK_BLOCK) {
+			k->unpack(packed + (i / FIXEDPT_PACK_BLOCK) * stride, width, mode, out);
+		} else {
+			size_t m;
+
+			k->unpack(packed + (i / FIXEDPT_PACK_BLOCK) * stride, width, mode, tmp);
+			for (m = 0; m < len; m++)
+				out[m] = tmp[j + m];
+		}
+	}
+}
+
+/*
+ * Streams a packed array through a batch kernel such as fixedpt_exp_batch:
+ * the elements are decoded a few blocks at a time into a buffer that stays
+ * in the L1 cache, and fn writes its results to out. The unpacked array is
+ * never materialized. fn is not called if width or mode is invalid.
+ */
+_FIXEDPT_FUNCTYPE void fixedpt_unpack_map(const uint64_t *packed, size_t n, int width, int mode,
+    void (*fn)(const fixedpt *, fixedpt *, size_t), fixedpt *out)
+{
+	fixedpt buf[4 * FIXEDPT_PACK_BLOCK];
+	size_t i, len;
+
+	if (!_FIXEDPT_PACK_VALID(width, mode))
+		return;
+	for (i = 0; i < n; i += len) {
+		len = (n - i < 4 * FIXEDPT_PACK_BLOCK) ? n - i : 4 * FIXEDPT_PACK_BLOCK;
+		fixedpt_unpack(packed, i, len, width, mode, buf);
+		fn(buf, out + i, len);
+	}
+}
+
+/* Returns the exact sum of n fixedpt numbers */
+_FIXEDPT_FUNCTYPE fixedpt_acc fixedpt_sum(const fixedpt *in, size_t n)
+{
+	fixedpt_acc sum;
+
+	_fixedpt_dispatch()->sum(in, n, &sum);
+	return (sum);
+}
+
+/* Returns the mean of n fixedpt numbers, rounded, or 0 if n is 0 */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_mean(const fixedpt *in, size_t n)
+{
+	if (n == 0)
+		return (0);
+	return ((fixedpt)_fixedpt_acc_div(fixedpt_sum(in, n), n));
+}
+
+/* Returns the population variance of n fixedpt numbers, saturated */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_var(const fixedpt *in, size_t n)
+{
+	fixedpt_stats s;
+
+	fixedpt_stats_init(&s);
+	fixedpt_stats_add(&s, in, n);
+	return (fixedpt_stats_var(&s));
+}
+
+/* Returns the root mean square of n fixedpt numbers, saturated */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_rms(const fixedpt *in, size_t n)
+{
+	fixedpt_stats s;
+
+	fixedpt_stats_init(&s);
+	fixedpt_stats_add(&s, in, n);
+	return (fixedpt_stats_rms(&s));
+}
+
+/*
+ * Stores the smallest and the largest of n fixedpt numbers, or
+ * FIXEDPT_MAX and FIXEDPT_MIN if n is 0.
+ */
+_FIXEDPT_FUNCTYPE void fixedpt_minmax(const fixedpt *in, size_t n, fixedpt *min, fixedpt *max)
+{
+	_fixedpt_dispatch()->minmax(in, n, min, max);
+}
+
+/*
+ * Adds the elements in [lo, hi) to counts, a histogram of nbins equal
+ * bins; the last bin also takes the remainder when hi - lo is not a
+ * multiple of nbins. counts is not cleared first, so a histogram can be
+ * built over several calls. Returns the number of elements outside
+ * [lo, hi), or n, counting nothing, if hi <= lo or there are more bins
+ * than representable values in the range.
+ */
+_FIXEDPT_FUNCTYPE size_t fixedpt_histogram(const fixedpt *in, size_t n, fixedpt lo, fixedpt hi,
+    size_t *counts, size_t nbins)
+{
+	const struct _fixedpt_kernel_table *k = _fixedpt_dispatch();
+	struct _fixedpt_bins b;
+	fixedptu idx[256];
+	size_t i, j, len, nout = 0;
+
+	b.range = (fixedptu)((fixedptu)hi - (fixedptu)lo);
+	if (hi <= lo || nbins == 0 || nbins > b.range)
+		return (n);
+	b.lo = lo;
+	b.nbins = (fixedptu)nbins;
+	b.w = (fixedptu)(b.range / b.nbins);
+	b.m = (fixedptu)((fixedptu)-1 / b.w);
+
+	/* Bins are computed a buffer at a time, the counting is scalar */
+	for (i = 0; i < n; i += len) {
+		len = (n - i < 256) ? n - i : 256;
+		k->hist(in + i, len, &b, idx);
+		for (j = 0; j < len; j++) {
+			if (idx[j] < nbins)
+				counts[idx[j]]++;
+			else
+				nout++;
+		}
+	}
+	return (nout);
+}
+
+/* Empties a running statistics accumulator */
+_FIXEDPT_FUNCTYPE void fixedpt_stats_init(fixedpt_stats *s)
+{
+	s->n = 0;
+	s->sum = 0;
+	s->sumsq_hi = 0;
+	s->sumsq_lo = 0;
+}
+
+/* Adds n elements to a running statistics accumulator */
+_FIXEDPT_FUNCTYPE void fixedpt_stats_add(fixedpt_stats *s, const fixedpt *in, size_t n)
+{
+	const struct _fixedpt_kernel_table *k = _fixedpt_dispatch();
+	size_t i, len;
+
+	for (i = 0; i < n; i += len) {
+		len = (n - i < _FIXEDPT_MOMENTS_CHUNK) ? n - i : _FIXEDPT_MOMENTS_CHUNK;
+		k->moments(in + i, len, s);
+		_fixedpt_stats_norm(s);
+	}
+	s->n += n;
+}
+
+/*
+ * Removes n elements added earlier, e.g. the oldest block of a sliding
+ * window, leaving the accumulator exactly as if they had never been added.
+ */
+_FIXEDPT_FUNCTYPE void fixedpt_stats_remove(fixedpt_stats *s, const fixedpt *in, size_t n)
+{
+	fixedpt_stats r;
+
+	fixedpt_stats_init(&r);
+	fixedpt_stats_add(&r, in, n);
+	s->n -= n;
+	s->sum -= r.sum;
+	s->sumsq_hi -= r.sumsq_hi;
+	s->sumsq_lo -= r.sumsq_lo;
+	_fixedpt_stats_norm(s);
+}
+
+/* Slides a window by one element: adds in and removes out, added earlier */
+_FIXEDPT_FUNCTYPE void fixedpt_stats_slide(fixedpt_stats *s, fixedpt in, fixedpt out)
+{
+	fixedptud a = (fixedptud)((fixedptd)in * in), b = (fixedptud)((fixedptd)out * out);
+
+	s->sum += (fixedpt_acc)in - out;
+	s->sumsq_hi += (fixedpt_acc)(a >> FIXEDPT_BITS) - (fixedpt_acc)(b >> FIXEDPT_BITS);
+	s->sumsq_lo += (fixedpt_acc)(fixedptu)a - (fixedpt_acc)(fixedptu)b;
+	_fixedpt_stats_norm(s);
+}
+
+/* Returns the mean of the accumulated elements, or 0 if there are none */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_stats_mean(const fixedpt_stats *s)
+{
+	if (s->n == 0)
+		return (0);
+	return ((fixedpt)_fixedpt_acc_div(s->sum, s->n));
+}
+
+/*
+ * Returns the population variance of the accumulated elements, saturated
+ * to FIXEDPT_MAX, or 0 if there are none. The mean square and the squared
+ * mean are both formed with 2 * FIXEDPT_FBITS fraction bits, the latter
+ * from the quotient and remainder of the sum, and rounded once after the
+ * subtraction.
+ */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_stats_var(const fixedpt_stats *s)
+{
+	const fixedpt_acc n = (fixedpt_acc)s->n;
+	fixedpt_acc q, r, var;
+
+	if (n == 0)
+		return (0);
+	q = (s->sum < 0) ? -s->sum : s->sum;
+	r = q % n;
+	q /= n;
+	/* (q + r / n)^2, less (r / n)^2 which is below one unit */
+	var = _fixedpt_acc2_div(s->sumsq_hi, s->sumsq_lo, n) - q * q -
+	    ((q * ((r << FIXEDPT_FBITS) / n)) >> (FIXEDPT_FBITS - 1));
+	var = (var + ((fixedpt_acc)1 << (FIXEDPT_FBITS - 1))) >> FIXEDPT_FBITS;
+	if (var < 0)
+		return (0);
+	return ((var > FIXEDPT_MAX) ? FIXEDPT_MAX : (fixedpt)var);
+}
+
+/*
+ * Returns the root mean square of the accumulated elements, saturated to
+ * FIXEDPT_MAX, or 0 if there are none.
+ */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_stats_rms(const fixedpt_stats *s)
+{
+	fixedpt_acc rms;
+
+	if (s->n == 0)
+		return (0);
+	rms = _fixedpt_acc_sqrt(_fixedpt_acc2_div(s->sumsq_hi, s->sumsq_lo, (fixedpt_acc)s->n));
+	return ((rms > FIXEDPT_MAX) ? FIXEDPT_MAX : (fixedpt)rms);
+}
+
+/*
+ * Describes a uniform axis of n >= 2 breakpoints x0 + k * 2^step, with
+ * step in fixedpt units, 0 <= step <= FIXEDPT_BITS - 2. Returns 0, or -1
+ * if the arguments are out of range or the grid passes FIXEDPT_MAX.
+ */
+_FIXEDPT_FUNCTYPE int fixedpt_lut_axis_uniform(fixedpt_lut_axis *a, fixedpt x0, int step, size_t n)
+{
+	if (n < 2 || step < 0 || step > FIXEDPT_BITS - 2 ||
+	    (uint64_t)(n - 1) > (uint64_t)((fixedptud)((fixedptd)FIXEDPT_MAX - x0) >> step))
+		return (-1);
+	a->x = NULL;
+	a->n = n;
+	a->x0 = x0;
+	a->step = step;
+	a->hint = 0;
+	return (0);
+}
+
+/*
+ * Describes an axis of n >= 2 breakpoints x, which must stay valid while
+ * the table is used. Returns 0, or -1 if they are not strictly increasing.
+ */
+_FIXEDPT_FUNCTYPE int fixedpt_lut_axis_points(fixedpt_lut_axis *a, const fixedpt *x, size_t n)
+{
+	size_t k;
+
+	if (n < 2)
+		return (-1);
+	for (k = 0; k + 1 < n; k++)
+		if (x[k] >= x[k + 1])
+			return (-1);
+	a->x = x;
+	a->n = n;
+	a->x0 = x[0];
+	a->step = 0;
+	a->hint = 0;
+	return (0);
+}
+
+/*
+ * Builds a 1D table of the values y at the breakpoints of the axis a. A
+ * non-uniform axis needs room for n - 1 slopes, which are computed here;
+ * a uniform one takes NULL. y and slope must stay valid while the table
+ * is used. Returns 0, or -1 if a slope is steeper than FIXEDPT_MAX per
+ * fixedpt unit.
+ */
+_FIXEDPT_FUNCTYPE int fixedpt_lut_init(fixedpt_lut *lut, const fixedpt_lut_axis *a, const fixedpt *y,
+    fixedpt_lut_seg *slope)
+{
+	const fixedptud lim = (fixedptud)FIXEDPT_MAX;
+	size_t k;
+
+	lut->a = *a;
+	lut->y = y;
+	lut->slope = slope;
+	if (a->x == NULL)
+		return (0);
+
+	for (k = 0; k + 1 < a->n; k++) {
+		fixedptud dx = (fixedptu)((fixedptu)a->x[k + 1] - (fixedptu)a->x[k]);
+		fixedptd dy = (fixedptd)y[k + 1] - y[k];
+		fixedptud ady = (fixedptud)((dy < 0) ? -dy : dy);
+		int sh = 0;
 
-	// Reduce z to [0, 1/32] using the identity atan(x) = atan{(x - c) / (1 + x * c)} + atan(c)
-	fixedpt c = fixedpt_rconst(31.0);
-	factor_c = c >> 5; // c / 32.0
-	while( fixedpt_sub(z, factor_c) < 0) {
-		c = fixedpt_sub(c, FIXEDPT_ONE);
-		factor_c = c >> 5; // c / 32.0
+		if (ady >= lim * dx)
+			return (-1);
+		/* The largest shift at which the rounded slope fits a fixedpt */
+		while (ady != 0 && sh < 2 * FIXEDPT_BITS - 2 && (ady << (sh + 1)) < lim * dx)
+			sh++;
+		dy *= (fixedptd)1 << sh;
+		slope[k].m = (fixedpt)((dy + ((dy < 0) ? -(fixedptd)dx : (fixedptd)dx) / 2) / (fixedptd)dx);
+		slope[k].shift = sh;
 	}
+	return (0);
+}
+
+/* Computes the reciprocal widths of a non-uniform 2D axis */
+static void _fixedpt_lut2_recip(const fixedpt_lut_axis *a, fixedpt_lut_seg *recip)
+{
+	size_t k;
+
+	for (k = 0; k + 1 < a->n; k++) {
+		fixedptud dx = (fixedptu)((fixedptu)a->x[k + 1] - (fixedptu)a->x[k]);
+		int sh = 0;
 
-	z = fixedpt_div( fixedpt_sub(z, factor_c), fixedpt_add(FIXEDPT_ONE, fixedpt_mul(z, factor_c)) );
+		/* 2^sh <= dx < 2^(sh + 1) puts the reciprocal in (2^(BITS - 3), 2^(BITS - 2)] */
+		while ((dx >> (sh + 1)) != 0)
+			sh++;
+		recip[k].m = (fixedpt)((((fixedptud)1 << (FIXEDPT_BITS - 2 + sh)) + dx / 2) / dx);
+		recip[k].shift = sh;
+	}
+}
 
-    // Polynomial computation
-    fixedpt z2 = fixedpt_mul(z, z);
-    theta = ( fixedpt_mul(z, fixedpt_add(E[0],
-		fixedpt_mul(z2, fixedpt_add(E[1],
-		fixedpt_mul(z2, fixedpt_add(E[2],
-		fixedpt_mul(z2, fixedpt_add(E[3],
-		fixedpt_mul(z2, fixedpt_add(E[4],
-		fixedpt_mul(z2, fixedpt_add(E[5],
-		fixedpt_mul(z2, E[6])
-	)))))))))))) );
+/*
+ * Builds a 2D table of the values z, with z[j * ax->n + i] at the point
+ * (x_i, y_j). Each non-uniform axis needs room for n - 1 reciprocal
+ * widths, computed here; uniform axes take NULL. z and the reciprocals
+ * must stay valid while the table is used. Returns 0.
+ */
+_FIXEDPT_FUNCTYPE int fixedpt_lut2_init(fixedpt_lut2 *lut, const fixedpt_lut_axis *ax, const fixedpt_lut_axis *ay,
+    const fixedpt *z, fixedpt_lut_seg *xrecip, fixedpt_lut_seg *yrecip)
+{
+	lut->a[0] = *ax;
+	lut->a[1] = *ay;
+	lut->z = z;
+	lut->recip[0] = xrecip;
+	lut->recip[1] = yrecip;
+	if (ax->x != NULL)
+		_fixedpt_lut2_recip(ax, xrecip);
+	if (ay->x != NULL)
+		_fixedpt_lut2_recip(ay, yrecip);
+	return (0);
+}
 
-	theta = fixedpt_add(theta, bias_atan[fixedpt_toint(c)]);
+/*
+ * Returns the table interpolated at x. The table remembers the segment
+ * for the next lookup, so a table is used by one thread at a time.
+ */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_lut_eval(fixedpt_lut *lut, fixedpt x)
+{
+	fixedptu t;
+	size_t k = _fixedpt_lut_find(&lut->a, x, &lut->a.hint, &t);
 
-	if(inverse_flag == 1)
-		theta = fixedpt_sub(FIXEDPT_HALF_PI, theta);  // Use arctan(z) = π/2 - arctan(1/z) for z > 1
+	if (lut->a.x == NULL)
+		return (_fixedpt_lut_u(lut, k, t));
+	return (_fixedpt_lut_p(lut, k, t));
+}
 
-	if(signflip_flag == 1)
-		theta = -theta;
+/* Interpolates the table at n points */
+_FIXEDPT_FUNCTYPE void fixedpt_lut_eval_batch(fixedpt_lut *lut, const fixedpt *in, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->lut(lut, in, out, n, &lut->a.hint);
+}
 
-	return theta;
+/* Returns the 2D table interpolated at (x, y), see fixedpt_lut_eval() */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_lut2_eval(fixedpt_lut2 *lut, fixedpt x, fixedpt y)
+{
+	return (_fixedpt_lut2(lut, x, y, &lut->a[0].hint, &lut->a[1].hint));
 }
 
-// atan2 implementation with domain reduction
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_atan2(fixedpt y, fixedpt x) 
+/* Interpolates the 2D table at the n points (x[i], y[i]) */
+_FIXEDPT_FUNCTYPE void fixedpt_lut2_eval_batch(fixedpt_lut2 *lut, const fixedpt *x, const fixedpt *y,
+    fixedpt *out, size_t n)
 {
-    if (x == 0) {
-        if (y > 0) return FIXEDPT_HALF_PI;   // Positive y-axis
-        if (y < 0) return -FIXEDPT_HALF_PI; // Negative y-axis
-        return 0;                  // Origin (undefined, return 0)
-    }
-    if (y == 0) {
-        return (x > 0 ? 0.0 : FIXEDPT_PI); // Positive or negative x-axis
-    }
+	size_t hint[2];
 
-	fixedpt theta = fixedpt_atan( fixedpt_div(y, x) );
+	hint[0] = lut->a[0].hint;
+	hint[1] = lut->a[1].hint;
+	_fixedpt_dispatch()->lut2(lut, x, y, out, n, hint);
+	lut->a[0].hint = hint[0];
+	lut->a[1].hint = hint[1];
+}
 
-    // Adjust theta for the correct quadrant
-    if (x < 0) {
-        if (y >= 0) {
-            theta = fixedpt_add(theta, FIXEDPT_PI); // Quadrant II
-        } else {
-            theta = fixedpt_sub(theta, FIXEDPT_PI); // Quadrant III
-        }
-    }
+/* Multiplies n pairs of complex numbers, see fixedpt_cmul() */
+_FIXEDPT_FUNCTYPE void fixedpt_cmul_batch(const fixedpt_complex *a, const fixedpt_complex *b,
+    fixedpt_complex *out, size_t n)
+{
+	_fixedpt_dispatch()->cmul(a, b, out, n);
+}
 
-    return theta;
+/* Multiplies n pairs of complex numbers held as separate arrays of parts */
+_FIXEDPT_FUNCTYPE void fixedpt_cmul_split_batch(const fixedpt *are, const fixedpt *aim,
+    const fixedpt *bre, const fixedpt *bim, fixedpt *re, fixedpt *im, size_t n)
+{
+	_fixedpt_dispatch()->cmul_split(are, aim, bre, bim, re, im, n);
 }
 
-/* Returns the arcsin of the given fixedpt number */
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_asin(fixedpt x)
+/* Computes the magnitudes of n complex numbers, see fixedpt_cabs() */
+_FIXEDPT_FUNCTYPE void fixedpt_cabs_batch(const fixedpt_complex *in, fixedpt *out, size_t n)
 {
-	/* Ensure input is within valid range (-1 to 1) */
-	if (x > FIXEDPT_ONE || x < -FIXEDPT_ONE) 
-	{
-		return x;
+	_fixedpt_dispatch()->cabs(in, out, n);
+}
+
+/* Computes the magnitudes of n complex numbers held as separate arrays of parts */
+_FIXEDPT_FUNCTYPE void fixedpt_cabs_split_batch(const fixedpt *re, const fixedpt *im, fixedpt *out, size_t n)
+{
+	_fixedpt_dispatch()->cabs_split(re, im, out, n);
+}
+
+/*
+ * Seeds the generator from SplitMix64. Generators with the same seed and
+ * different streams, e.g. one per thread, draw independent sequences.
+ */
+_FIXEDPT_FUNCTYPE void fixedpt_rng_init(fixedpt_rng *rng, uint64_t seed, uint64_t stream)
+{
+	uint64_t x = seed ^ _fixedpt_splitmix64(&stream);
+	int i, j;
+
+	for (i = 0; i < 4; i++)
+		for (j = 0; j < FIXEDPT_RNG_LANES; j++)
+			rng->s[i][j] = _fixedpt_splitmix64(&x);
+	rng->pos = FIXEDPT_RNG_LANES;
+}
+
+/* Returns the next 64 random bits */
+_FIXEDPT_FUNCTYPE uint64_t fixedpt_rng_bits(fixedpt_rng *rng)
+{
+	return (_fixedpt_rng_next(rng));
+}
+
+/* Returns a uniform random number in [0, 1) */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_rng_uniform(fixedpt_rng *rng)
+{
+	return (_fixedpt_rng_conv(_fixedpt_rng_next(rng), _FIXEDPT_RNG_UNIFORM, 0, 0));
+}
+
+/* Returns a uniform random number in [lo, hi), or lo if hi <= lo */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_rng_range(fixedpt_rng *rng, fixedpt lo, fixedpt hi)
+{
+	fixedptu w = (hi > lo) ? (fixedptu)hi - (fixedptu)lo : 0;
+
+	return (_fixedpt_rng_conv(_fixedpt_rng_next(rng), _FIXEDPT_RNG_RANGE, lo, w));
+}
+
+/*
+ * Returns a random number in (-amp, amp) with a triangular density, the
+ * difference of two uniforms: dither of amp = one quantization step has
+ * an error whose mean and variance do not depend on the signal.
+ */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_rng_triangular(fixedpt_rng *rng, fixedpt amp)
+{
+	return (_fixedpt_rng_conv(_fixedpt_rng_next(rng), _FIXEDPT_RNG_TRIANGULAR, 0, (fixedptu)amp));
+}
+
+/* Fills out with n draws of the given kind, continuing the sequence of rng */
+_FIXEDPT_INLINE void _fixedpt_rng_fill(fixedpt_rng *rng, fixedpt *out, size_t n, int kind,
+    fixedpt lo, fixedptu w)
+{
+	size_t nblk;
+
+	for (; n > 0 && rng->pos < FIXEDPT_RNG_LANES; n--)
+		*out++ = _fixedpt_rng_conv(rng->buf[rng->pos++], kind, lo, w);
+	nblk = n / FIXEDPT_RNG_LANES;
+	_fixedpt_dispatch()->rng(rng, out, nblk, kind, lo, w);
+	out += nblk * FIXEDPT_RNG_LANES;
+	for (n -= nblk * FIXEDPT_RNG_LANES; n > 0; n--)
+		*out++ = _fixedpt_rng_conv(_fixedpt_rng_next(rng), kind, lo, w);
+}
+
+/* Fills out with n uniform random numbers in [0, 1) */
+_FIXEDPT_FUNCTYPE void fixedpt_rng_uniform_fill(fixedpt_rng *rng, fixedpt *out, size_t n)
+{
+	_fixedpt_rng_fill(rng, out, n, _FIXEDPT_RNG_UNIFORM, 0, 0);
+}
+
+/* Fills out with n uniform random numbers in [lo, hi) */
+_FIXEDPT_FUNCTYPE void fixedpt_rng_range_fill(fixedpt_rng *rng, fixedpt lo, fixedpt hi, fixedpt *out, size_t n)
+{
+	_fixedpt_rng_fill(rng, out, n, _FIXEDPT_RNG_RANGE, lo, (hi > lo) ? (fixedptu)hi - (fixedptu)lo : 0);
+}
+
+/* Fills out with n triangular random numbers in (-amp, amp) */
+_FIXEDPT_FUNCTYPE void fixedpt_rng_triangular_fill(fixedpt_rng *rng, fixedpt amp, fixedpt *out, size_t n)
+{
+	_fixedpt_rng_fill(rng, out, n, _FIXEDPT_RNG_TRIANGULAR, 0, (fixedptu)amp);
+}
+
+#if FIXEDPT_WBITS >= 6
+/* Returns a standard normal random number */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_rng_normal(fixedpt_rng *rng)
+{
+	return (_fixedpt_rng_normal(rng));
+}
+
+/*
+ * Fills out with n standard normal random numbers. Rejections make the
+ * ziggurat draw a variable number of bits, so this is a scalar loop over
+ * the same sequence.
+ */
+_FIXEDPT_FUNCTYPE void fixedpt_rng_normal_fill(fixedpt_rng *rng, fixedpt *out, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		out[i] = _fixedpt_rng_normal(rng);
+}
+#endif
+
+/* Moves the block to phase, and starts the rotation for freq */
+static void _fixedpt_nco_start(fixedpt_nco *nco, uint64_t phase, uint64_t phase_lo,
+    uint64_t freq, uint64_t freq_lo)
+{
+	uint64_t w, lo;
+
+	nco->phase = phase;
+	nco->phase_lo = phase_lo;
+	nco->freq = freq;
+	nco->freq_lo = freq_lo;
+	w = _fixedpt_nco_step(0, 0, freq, freq_lo, FIXEDPT_NCO_LANES, &lo);
+	_fixedpt_nco_sincos(w + (lo >> 63), &nco->ws, &nco->wc);
+	_fixedpt_nco_block(nco->s, nco->c, phase, phase_lo, freq, freq_lo);
+	nco->pos = 0;
+	nco->left = _FIXEDPT_NCO_SPAN - 1;
+}
+
+/*
+ * Starts an oscillator whose sample k is at the angle phase + k * freq,
+ * both in radians. The angles are not reduced with a rounded 2 pi as
+ * fixedpt_sin() reduces them, and freq is kept to 2^-128 turns, so the
+ * phase is off by less than an LSB of every format for 2^48 samples.
+ */
+_FIXEDPT_FUNCTYPE void fixedpt_nco_init(fixedpt_nco *nco, fixedpt freq, fixedpt phase)
+{
+	uint64_t p, pl, f, fl;
+
+	p = _fixedpt_nco_turns(phase, &pl);
+	f = _fixedpt_nco_turns(freq, &fl);
+	_fixedpt_nco_start(nco, p, pl, f, fl);
+}
+
+/* Changes the frequency from the next sample on, keeping the phase continuous */
+_FIXEDPT_FUNCTYPE void fixedpt_nco_set_freq(fixedpt_nco *nco, fixedpt freq)
+{
+	uint64_t p, pl, f, fl;
+
+	p = _fixedpt_nco_step(nco->phase, nco->phase_lo, nco->freq, nco->freq_lo, nco->pos, &pl);
+	f = _fixedpt_nco_turns(freq, &fl);
+	_fixedpt_nco_start(nco, p, pl, f, fl);
+}
+
+/* Sets *s and *c to the sine and cosine of the next sample */
+_FIXEDPT_FUNCTYPE void fixedpt_nco_next(fixedpt_nco *nco, fixedpt *s, fixedpt *c)
+{
+	if (nco->pos == FIXEDPT_NCO_LANES) {
+		_fixedpt_nco_advance(nco->s, nco->c, nco->ws, nco->wc, &nco->phase, &nco->phase_lo,
+		    nco->freq, nco->freq_lo, &nco->left);
+		nco->pos = 0;
+	}
+	*s = _fixedpt_pround(nco->s[nco->pos]);
+	*c = _fixedpt_pround(nco->c[nco->pos]);
+	nco->pos++;
+}
+
+/*
+ * Fills s and c with the sines and cosines of the next n samples, the
+ * same as n calls of fixedpt_nco_next(). Either may be NULL.
+ */
+_FIXEDPT_FUNCTYPE void fixedpt_nco_fill(fixedpt_nco *nco, fixedpt *s, fixedpt *c, size_t n)
+{
+	size_t i, nblk;
+
+	for (i = 0; i < n && nco->pos < FIXEDPT_NCO_LANES; i++, nco->pos++) {
+		if (s != NULL)
+			s[i] = _fixedpt_pround(nco->s[nco->pos]);
+		if (c != NULL)
+			c[i] = _fixedpt_pround(nco->c[nco->pos]);
 	}
+	nblk = (n - i) / FIXEDPT_NCO_LANES;
+	if (nblk > 0) {
+		_fixedpt_dispatch()->nco(nco, (s != NULL) ? s + i : NULL, (c != NULL) ? c + i : NULL, nblk);
+		i += nblk * FIXEDPT_NCO_LANES;
+	}
+	for (; i < n; i++) {
+		fixedpt sv, cv;
 
-	/* Handle special cases (x = ±1) */
-	if (x == FIXEDPT_ONE) 
-	{
-		return FIXEDPT_HALF_PI;
-	} 
-	else if (x == -FIXEDPT_ONE) 
-	{
-		return -FIXEDPT_HALF_PI;
+		fixedpt_nco_next(nco, &sv, &cv);
+		if (s != NULL)
+			s[i] = sv;
+		if (c != NULL)
+			c[i] = cv;
 	}
+}
 
-	return fixedpt_atan2(x, fixedpt_sqrt(fixedpt_sub(FIXEDPT_ONE, fixedpt_mul(x, x))));
+/*
+ * Parallel map and reductions.
+ *
+ * These use OpenMP when the including translation unit is built with it
+ * (e.g. -fopenmp) and run serially otherwise, so the header does not pull
+ * in a thread library of its own. The arrays are cut into chunks of
+ * FIXEDPT_PARALLEL_CHUNK elements. Maps hand the chunks out dynamically,
+ * since fixedpt_ln and fixedpt_sqrt cost more for some inputs than for
+ * others. Reductions are memory bound and use a static schedule, which
+ * keeps each chunk on the same thread across calls, so pages first
+ * touched by that thread stay on its NUMA node. Arrays shorter than two
+ * chunks are processed on the calling thread.
+ *
+ * The results do not depend on the thread count: the sum is exact integer
+ * arithmetic in a fixedpt_acc, as in fixedpt_sum(), so the order of the
+ * partial sums cannot change it.
+ */
+
+/* Stores fn(in[i]) into out[i] for n elements */
+_FIXEDPT_FUNCTYPE void fixedpt_parallel_map(fixedpt (*fn)(fixedpt), const fixedpt *in, fixedpt *out, size_t n)
+{
+	size_t i;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, FIXEDPT_PARALLEL_CHUNK) if (n >= 2 * FIXEDPT_PARALLEL_CHUNK)
+#endif
+	for (i = 0; i < n; i++)
+		out[i] = fn(in[i]);
 }
 
-/* Returns the arccos of the given fixedpt number */
-_FIXEDPT_FUNCTYPE fixedpt fixedpt_acos(fixedpt x)
+/* Runs a batch kernel such as fixedpt_exp_batch over n elements, one chunk per call */
+_FIXEDPT_FUNCTYPE void fixedpt_parallel_map_batch(void (*fn)(const fixedpt *, fixedpt *, size_t),
+    const fixedpt *in, fixedpt *out, size_t n)
 {
-	/* Ensure input is within valid range (-1 to 1) */
-	if (x > FIXEDPT_ONE || x < -FIXEDPT_ONE) 
-	{
-		return x;
+	const size_t chunk = FIXEDPT_PARALLEL_CHUNK;
+	size_t c, nchunks = (n + chunk - 1) / chunk;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) if (nchunks >= 2)
+#endif
+	for (c = 0; c < nchunks; c++) {
+		size_t off = c * chunk;
+
+		fn(in + off, out + off, (n - off < chunk) ? n - off : chunk);
 	}
+}
 
-	/* Handle special cases (x = ±1) */
-	if (x == FIXEDPT_ONE) 
-	{
-		return 0;
-	} 
-	else if (x == -FIXEDPT_ONE) 
-	{
-		return FIXEDPT_PI;
+/* Returns the exact sum of n fixedpt numbers */
+_FIXEDPT_FUNCTYPE fixedpt_acc fixedpt_parallel_sum(const fixedpt *in, size_t n)
+{
+	fixedpt_acc sum = 0;
+	size_t i;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, FIXEDPT_PARALLEL_CHUNK) reduction(+:sum) if (n >= 2 * FIXEDPT_PARALLEL_CHUNK)
+#endif
+	for (i = 0; i < n; i++)
+		sum += in[i];
+	return (sum);
+}
+
+/* Returns the smallest of n fixedpt numbers, or FIXEDPT_MAX if n is 0 */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_parallel_min(const fixedpt *in, size_t n)
+{
+	fixedpt min = FIXEDPT_MAX;
+	size_t i;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, FIXEDPT_PARALLEL_CHUNK) reduction(min:min) if (n >= 2 * FIXEDPT_PARALLEL_CHUNK)
+#endif
+	for (i = 0; i < n; i++)
+		min = (in[i] < min) ? in[i] : min;
+	return (min);
+}
+
+/* Returns the largest of n fixedpt numbers, or FIXEDPT_MIN if n is 0 */
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_parallel_max(const fixedpt *in, size_t n)
+{
+	fixedpt max = FIXEDPT_MIN;
+	size_t i;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, FIXEDPT_PARALLEL_CHUNK) reduction(max:max) if (n >= 2 * FIXEDPT_PARALLEL_CHUNK)
+#endif
+	for (i = 0; i < n; i++)
+		max = (in[i] > max) ? in[i] : max;
+	return (max);
+}
+
+#ifdef FIXEDPT_HAVE_FILE
+/*
+ * Binary array files.
+ *
+ * The header fields are in the byte order of the writer, which the endian
+ * byte records, so writing is a plain copy of memory. A file in this
+ * build's format is mapped and used in place; a file with another width,
+ * FIXEDPT_WBITS or byte order is converted into a heap copy if the caller
+ * allows it, rescaling by a shift with rounding and saturation.
+ *
+ * A streaming writer leaves the count at _FIXEDPT_FILE_STREAMING until it
+ * is closed, and readers then take every whole element the file holds, so
+ * an interrupted capture is still readable up to its last write.
+ */
+#define _FIXEDPT_FILE_HEADER	64
+#define _FIXEDPT_FILE_VERSION	1
+#define _FIXEDPT_FILE_LITTLE	1
+#define _FIXEDPT_FILE_BIG	2
+#define _FIXEDPT_FILE_STREAMING	UINT64_MAX
+
+struct _fixedpt_file_header {
+	char magic[4];		/* "FXPT" */
+	uint8_t version;
+	uint8_t bits;		/* FIXEDPT_BITS */
+	uint8_t wbits;		/* FIXEDPT_WBITS */
+	uint8_t endian;		/* _FIXEDPT_FILE_LITTLE or _FIXEDPT_FILE_BIG */
+	uint32_t offset;	/* of the elements, a multiple of 64 */
+	uint32_t reserved0;
+	uint64_t count;		/* elements, or _FIXEDPT_FILE_STREAMING */
+	uint8_t reserved[40];
+};
+
+_FIXEDPT_INLINE int _fixedpt_file_endian(void)
+{
+	const uint16_t one = 1;
+
+	return (*(const uint8_t *)&one ? _FIXEDPT_FILE_LITTLE : _FIXEDPT_FILE_BIG);
+}
+
+/* Reads an unsigned integer of the given size and byte order */
+_FIXEDPT_INLINE uint64_t _fixedpt_file_uint(const unsigned char *p, int bytes, int endian)
+{
+	uint64_t u = 0;
+	int i;
+
+	for (i = 0; i < bytes; i++)
+		u = (u << 8) | p[endian == _FIXEDPT_FILE_BIG ? i : bytes - 1 - i];
+	return (u);
+}
+
+static void _fixedpt_file_header_init(struct _fixedpt_file_header *h, uint64_t count)
+{
+	memset(h, 0, sizeof(*h));
+	memcpy(h->magic, "FXPT", 4);
+	h->version = _FIXEDPT_FILE_VERSION;
+	h->bits = FIXEDPT_BITS;
+	h->wbits = FIXEDPT_WBITS;
+	h->endian = (uint8_t)_fixedpt_file_endian();
+	h->offset = _FIXEDPT_FILE_HEADER;
+	h->count = count;
+}
+
+/* Writes all of buf, retrying short writes */
+static int _fixedpt_file_put(int fd, const void *buf, size_t len)
+{
+	const char *p = (const char *)buf;
+
+	while (len > 0) {
+		ssize_t r = write(fd, p, len);
+
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			return (-1);
+		}
+		p += r;
+		len -= (size_t)r;
+	}
+	return (0);
+}
+
+/*
+ * Converts an element of another format: sign-extends it, then shifts it
+ * from fbits to FIXEDPT_FBITS fraction bits, rounding to nearest when
+ * bits are dropped and saturating when the whole part does not fit.
+ */
+static fixedpt _fixedpt_file_convert(const unsigned char *p, int bits, int fbits, int endian)
+{
+	int64_t v = (int64_t)(_fixedpt_file_uint(p, bits / 8, endian) << (64 - bits)) >> (64 - bits);
+	int shift = FIXEDPT_FBITS - fbits;
+
+	if (shift < 0) {
+		v = ((v >> (-shift - 1)) + 1) >> 1;
+	} else if (shift > 0) {
+		if (v > (INT64_MAX >> shift))
+			return (FIXEDPT_MAX);
+		if (v < (INT64_MIN >> shift))
+			return (FIXEDPT_MIN);
+		v = (int64_t)((uint64_t)v << shift);
+	}
+	if (v > (int64_t)FIXEDPT_MAX)
+		return (FIXEDPT_MAX);
+	if (v < (int64_t)FIXEDPT_MIN)
+		return (FIXEDPT_MIN);
+	return ((fixedpt)v);
+}
+
+/*
+ * Maps a fixedpt array file and points view->data at its elements. A file
+ * in this build's format is used in place, with no copy. Otherwise this
+ * fails with FIXEDPT_FILE_EQFORMAT, unless flags has FIXEDPT_FILE_CONVERT,
+ * which converts the elements into a heap copy. Returns 0, -1 on a system
+ * error (see errno) or FIXEDPT_FILE_EFORMAT for a malformed file. The view
+ * is released with fixedpt_file_unmap().
+ */
+_FIXEDPT_FUNCTYPE int fixedpt_file_map(const char *path, fixedpt_file_view *view, int flags)
+{
+	const unsigned char *h;
+	uint64_t count, avail, offset;
+	int fd, bits, wbits, endian, esize;
+	struct stat st;
+	void *map;
+	size_t i;
+
+	memset(view, 0, sizeof(*view));
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return (-1);
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return (-1);
+	}
+	if (st.st_size < _FIXEDPT_FILE_HEADER) {
+		close(fd);
+		return (FIXEDPT_FILE_EFORMAT);
+	}
+	if ((uint64_t)st.st_size > SIZE_MAX) {
+		close(fd);
+		errno = EFBIG;
+		return (-1);
+	}
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return (-1);
+
+	h = (const unsigned char *)map;
+	bits = h[5];
+	wbits = h[6];
+	endian = h[7];
+	esize = bits / 8;
+	offset = _fixedpt_file_uint(h + 8, 4, endian);
+	count = _fixedpt_file_uint(h + 16, 8, endian);
+	if (memcmp(h, "FXPT", 4) != 0 || h[4] != _FIXEDPT_FILE_VERSION ||
+	    (bits != 16 && bits != 32 && bits != 64) || wbits > bits ||
+	    (endian != _FIXEDPT_FILE_LITTLE && endian != _FIXEDPT_FILE_BIG) ||
+	    offset < _FIXEDPT_FILE_HEADER || offset % 64 != 0 ||
+	    offset > (uint64_t)st.st_size)
+		goto bad;
+	avail = ((uint64_t)st.st_size - offset) / (uint64_t)esize;
+	if (count == _FIXEDPT_FILE_STREAMING)
+		count = avail;
+	else if (count > avail)
+		goto bad;
+
+	view->count = (size_t)count;
+	if (bits == FIXEDPT_BITS && wbits == FIXEDPT_WBITS &&
+	    endian == _fixedpt_file_endian()) {
+		view->data = (const fixedpt *)(h + offset);
+		view->map = map;
+		view->maplen = (size_t)st.st_size;
+		return (0);
+	}
+	if (!(flags & FIXEDPT_FILE_CONVERT)) {
+		munmap(map, (size_t)st.st_size);
+		memset(view, 0, sizeof(*view));
+		return (FIXEDPT_FILE_EQFORMAT);
+	}
+	view->buf = (fixedpt *)malloc(count ? (size_t)count * sizeof(fixedpt) : 1);
+	if (view->buf == NULL) {
+		munmap(map, (size_t)st.st_size);
+		memset(view, 0, sizeof(*view));
+		return (-1);
+	}
+	for (i = 0; i < count; i++)
+		view->buf[i] = _fixedpt_file_convert(h + offset + i * (size_t)esize,
+		    bits, bits - wbits, endian);
+	munmap(map, (size_t)st.st_size);
+	view->data = view->buf;
+	return (0);
+
+bad:
+	munmap(map, (size_t)st.st_size);
+	memset(view, 0, sizeof(*view));
+	return (FIXEDPT_FILE_EFORMAT);
+}
+
+/* Releases a view from fixedpt_file_map() or fixedpt_file_create() */
+_FIXEDPT_FUNCTYPE void fixedpt_file_unmap(fixedpt_file_view *view)
+{
+	if (view->map != NULL)
+		munmap(view->map, view->maplen);
+	free(view->buf);
+	memset(view, 0, sizeof(*view));
+}
+
+/*
+ * Creates a file of n elements and maps it writable, for producers that
+ * fill the array in place. *data points at the elements, which start out
+ * as zero; fixedpt_file_unmap() releases the view and the kernel writes
+ * the pages back. Returns 0 or -1 (see errno).
+ */
+_FIXEDPT_FUNCTYPE int fixedpt_file_create(const char *path, size_t n, fixedpt_file_view *view, fixedpt **data)
+{
+	struct _fixedpt_file_header h;
+	size_t len = _FIXEDPT_FILE_HEADER + n * sizeof(fixedpt);
+	void *map;
+	int fd;
+
+	memset(view, 0, sizeof(*view));
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return (-1);
+	/* Extend the file to len bytes by writing its last one */
+	if (lseek(fd, (off_t)(len - 1), SEEK_SET) < 0 ||
+	    _fixedpt_file_put(fd, "", 1) < 0) {
+		close(fd);
+		return (-1);
+	}
+	map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return (-1);
+	_fixedpt_file_header_init(&h, n);
+	memcpy(map, &h, sizeof(h));
+
+	*data = (fixedpt *)((char *)map + _FIXEDPT_FILE_HEADER);
+	view->data = *data;
+	view->count = n;
+	view->map = map;
+	view->maplen = len;
+	return (0);
+}
+
+/* Writes n elements to a new file. Returns 0 or -1 (see errno). */
+_FIXEDPT_FUNCTYPE int fixedpt_file_write(const char *path, const fixedpt *data, size_t n)
+{
+	fixedpt_file_writer w;
+
+	if (fixedpt_writer_open(&w, path) < 0)
+		return (-1);
+	if (fixedpt_writer_append(&w, data, n) < 0) {
+		int err = errno;
+
+		fixedpt_writer_close(&w);
+		errno = err;
+		return (-1);
 	}
+	return (fixedpt_writer_close(&w));
+}
+
+/* Starts an append-only file. Returns 0 or -1 (see errno). */
+_FIXEDPT_FUNCTYPE int fixedpt_writer_open(fixedpt_file_writer *w, const char *path)
+{
+	struct _fixedpt_file_header h;
+
+	w->count = 0;
+	w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (w->fd < 0)
+		return (-1);
+	_fixedpt_file_header_init(&h, _FIXEDPT_FILE_STREAMING);
+	if (_fixedpt_file_put(w->fd, &h, sizeof(h)) < 0) {
+		int err = errno;
+
+		close(w->fd);
+		w->fd = -1;
+		errno = err;
+		return (-1);
+	}
+	return (0);
+}
+
+/* Appends n elements. Returns 0 or -1 (see errno). */
+_FIXEDPT_FUNCTYPE int fixedpt_writer_append(fixedpt_file_writer *w, const fixedpt *data, size_t n)
+{
+	if (_fixedpt_file_put(w->fd, data, n * sizeof(fixedpt)) < 0)
+		return (-1);
+	w->count += n;
+	return (0);
+}
+
+/* Records the element count and closes the file. Returns 0 or -1 (see errno). */
+_FIXEDPT_FUNCTYPE int fixedpt_writer_close(fixedpt_file_writer *w)
+{
+	struct _fixedpt_file_header h;
+	int r = 0;
+
+	_fixedpt_file_header_init(&h, w->count);
+	if (lseek(w->fd, (off_t)offsetof(struct _fixedpt_file_header, count), SEEK_SET) < 0 ||
+	    _fixedpt_file_put(w->fd, &h.count, sizeof(h.count)) < 0)
+		r = -1;
+	if (close(w->fd) < 0)
+		r = -1;
+	w->fd = -1;
+	return (r);
+}
+#endif
+
+#ifdef FIXEDPT_TRACE
+/*
+ * The public names of the traced functions. The empty asm statements tie
+ * the arguments and the result to the timed interval, so that the
+ * compiler cannot move the work out of it.
+ */
+#undef fixedpt_mul
+#undef fixedpt_div
+#undef fixedpt_fma
+#undef fixedpt_mla
+#undef fixedpt_mls
+#undef fixedpt_sqrt
+#undef fixedpt_exp
+#undef fixedpt_ln
+#undef fixedpt_log
+#undef fixedpt_pow
+#undef fixedpt_sin
+#undef fixedpt_cos
+#undef fixedpt_sincos
+#undef fixedpt_tan
+#undef fixedpt_asin
+#undef fixedpt_acos
+#undef fixedpt_atan
+#undef fixedpt_atan2
+
+#define _FIXEDPT_TRACE_TIE(v)	__asm__ __volatile__("" : "+r"(v))
+
+#define _FIXEDPT_TRACED1(id, name)					\
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_##name(fixedpt a)			\
+{									\
+	uint64_t t = _fixedpt_trace_begin(id);				\
+	fixedpt r;							\
+									\
+	_FIXEDPT_TRACE_TIE(a);						\
+	r = _fixedpt_##name##_untraced(a);				\
+	_FIXEDPT_TRACE_TIE(r);						\
+	if (__builtin_expect(t != 0, 0))				\
+		_fixedpt_trace_end(id, t, _fixedpt_trace_mag(a));	\
+	return (r);							\
+}
 
-	return fixedpt_atan2(fixedpt_sqrt(fixedpt_sub(FIXEDPT_ONE, fixedpt_mul(x, x))), x);
+#define _FIXEDPT_TRACED2(id, name)					\
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_##name(fixedpt a, fixedpt b)		\
+{									\
+	uint64_t t = _fixedpt_trace_begin(id);				\
+	fixedpt r;							\
+									\
+	_FIXEDPT_TRACE_TIE(a);						\
+	_FIXEDPT_TRACE_TIE(b);						\
+	r = _fixedpt_##name##_untraced(a, b);				\
+	_FIXEDPT_TRACE_TIE(r);						\
+	if (__builtin_expect(t != 0, 0))				\
+		_fixedpt_trace_end(id, t, _fixedpt_trace_mag(a) |	\
+		    _fixedpt_trace_mag(b));				\
+	return (r);							\
 }
 
+#define _FIXEDPT_TRACED3(id, name)					\
+_FIXEDPT_FUNCTYPE fixedpt fixedpt_##name(fixedpt a, fixedpt b, fixedpt c)	\
+{									\
+	uint64_t t = _fixedpt_trace_begin(id);				\
+	fixedpt r;							\
+									\
+	_FIXEDPT_TRACE_TIE(a);						\
+	_FIXEDPT_TRACE_TIE(b);						\
+	_FIXEDPT_TRACE_TIE(c);						\
+	r = _fixedpt_##name##_untraced(a, b, c);			\
+	_FIXEDPT_TRACE_TIE(r);						\
+	if (__builtin_expect(t != 0, 0))				\
+		_fixedpt_trace_end(id, t, _fixedpt_trace_mag(a) |	\
+		    _fixedpt_trace_mag(b) | _fixedpt_trace_mag(c));	\
+	return (r);							\
+}
+
+_FIXEDPT_TRACED2(FIXEDPT_TRACE_MUL, mul)
+_FIXEDPT_TRACED2(FIXEDPT_TRACE_DIV, div)
+_FIXEDPT_TRACED3(FIXEDPT_TRACE_FMA, fma)
+_FIXEDPT_TRACED3(FIXEDPT_TRACE_MLA, mla)
+_FIXEDPT_TRACED3(FIXEDPT_TRACE_MLS, mls)
+_FIXEDPT_TRACED1(FIXEDPT_TRACE_SQRT, sqrt)
+_FIXEDPT_TRACED1(FIXEDPT_TRACE_EXP, exp)
+_FIXEDPT_TRACED1(FIXEDPT_TRACE_LN, ln)
+_FIXEDPT_TRACED2(FIXEDPT_TRACE_LOG, log)
+_FIXEDPT_TRACED2(FIXEDPT_TRACE_POW, pow)
+_FIXEDPT_TRACED1(FIXEDPT_TRACE_SIN, sin)
+_FIXEDPT_TRACED1(FIXEDPT_TRACE_COS, cos)
+_FIXEDPT_TRACED1(FIXEDPT_TRACE_TAN, tan)
+_FIXEDPT_TRACED1(FIXEDPT_TRACE_ASIN, asin)
+_FIXEDPT_TRACED1(FIXEDPT_TRACE_ACOS, acos)
+_FIXEDPT_TRACED1(FIXEDPT_TRACE_ATAN, atan)
+_FIXEDPT_TRACED2(FIXEDPT_TRACE_ATAN2, atan2)
+
+_FIXEDPT_FUNCTYPE void fixedpt_sincos(fixedpt a, fixedpt *s, fixedpt *c)
+{
+	uint64_t t = _fixedpt_trace_begin(FIXEDPT_TRACE_SINCOS);
+
+	_FIXEDPT_TRACE_TIE(a);
+	_fixedpt_sincos_untraced(a, s, c);
+	__asm__ __volatile__("" : : : "memory");
+	if (__builtin_expect(t != 0, 0))
+		_fixedpt_trace_end(FIXEDPT_TRACE_SINCOS, t, _fixedpt_trace_mag(a));
+}
+#endif
+
 #ifdef __cplusplus
 }
 #endif
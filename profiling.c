@@ -10,6 +10,9 @@
 
 //#define FIXEDPT_WBITS 8
 
+/* Build with FIXEDPT_POLY_HORNER to compare the transcendental functions */
+//#define FIXEDPT_POLY_SCHEME FIXEDPT_POLY_HORNER
+
 #define _FIXEDPT_IMPLEMENTATION
 #include "fixedptc.h"
 
@@ -43,6 +46,14 @@ static const fixedpt atan_4_x = fixedpt_rconst(1.0);
 static const fixedpt atan_5_x = fixedpt_rconst(0.866025403);
 
 static const fixedpt x_profile = fixedpt_rconst(1000);
+static const fixedpt x_poly = fixedpt_rconst(0.3);
+
+/* Taylor series of e^x, for the polynomial evaluation schemes */
+static const fixedpt poly_coef[9] = {
+    fixedpt_rconst(1.0), fixedpt_rconst(1.0), fixedpt_rconst(1.0 / 2),
+    fixedpt_rconst(1.0 / 6), fixedpt_rconst(1.0 / 24), fixedpt_rconst(1.0 / 120),
+    fixedpt_rconst(1.0 / 720), fixedpt_rconst(1.0 / 5040), fixedpt_rconst(1.0 / 40320)
+};
 
 // Function to measure the execution time of a function in microseconds
 uint64_t measure_time_us(void (*func)()) {
@@ -67,6 +78,62 @@ void calculate_sin() {
     }
 }
 
+void calculate_orig_cos() {
+    volatile double result;
+    for (int i = 0; i < PROFILE_ITERATIONS; i++) {
+        result = cos(e_d);
+    }
+}
+
+void calculate_cos() {
+    volatile fixedpt result;
+    for (int i = 0; i < PROFILE_ITERATIONS; i++) {
+        result = fixedpt_cos(e_x);
+    }
+}
+
+void calculate_orig_exp() {
+    volatile double result;
+    for (int i = 0; i < PROFILE_ITERATIONS; i++) {
+        result = exp(e_d);
+    }
+}
+
+void calculate_exp() {
+    volatile fixedpt result;
+    for (int i = 0; i < PROFILE_ITERATIONS; i++) {
+        result = fixedpt_exp(e_x);
+    }
+}
+
+void calculate_orig_atan() {
+    volatile double result;
+    for (int i = 0; i < PROFILE_ITERATIONS; i++) {
+        result = atan(atan_3_d);
+    }
+}
+
+void calculate_atan() {
+    volatile fixedpt result;
+    for (int i = 0; i < PROFILE_ITERATIONS; i++) {
+        result = fixedpt_atan(atan_3_x);
+    }
+}
+
+void calculate_poly_horner() {
+    volatile fixedpt result;
+    for (int i = 0; i < PROFILE_ITERATIONS; i++) {
+        result = fixedpt_poly(x_poly, poly_coef, 8, FIXEDPT_POLY_HORNER);
+    }
+}
+
+void calculate_poly_estrin() {
+    volatile fixedpt result;
+    for (int i = 0; i < PROFILE_ITERATIONS; i++) {
+        result = fixedpt_poly(x_poly, poly_coef, 8, FIXEDPT_POLY_ESTRIN);
+    }
+}
+
 void calculate_orig_log() {
     volatile double result;
     for (int i = 0; i < PROFILE_ITERATIONS; i++) {
@@ -109,6 +176,24 @@ int main() {
         time_dif = measure_time_us(calculate_sin);
         printf("Time taken by sin function: %llu microseconds\n", time_dif);
 
+        time_dif = measure_time_us(calculate_orig_cos);
+        printf("Time taken by floating-point cos function: %llu microseconds\n", time_dif);
+
+        time_dif = measure_time_us(calculate_cos);
+        printf("Time taken by cos function: %llu microseconds\n", time_dif);
+
+        time_dif = measure_time_us(calculate_orig_exp);
+        printf("Time taken by floating-point exp function: %llu microseconds\n", time_dif);
+
+        time_dif = measure_time_us(calculate_exp);
+        printf("Time taken by exp function: %llu microseconds\n", time_dif);
+
+        time_dif = measure_time_us(calculate_orig_atan);
+        printf("Time taken by floating-point atan function: %llu microseconds\n", time_dif);
+
+        time_dif = measure_time_us(calculate_atan);
+        printf("Time taken by atan function: %llu microseconds\n", time_dif);
+
         time_dif = measure_time_us(calculate_orig_log);
         printf("Time taken by floating-point log function: %llu microseconds\n", time_dif);
 
@@ -121,6 +206,12 @@ int main() {
         time_dif = measure_time_us(calculate_sqrt);
         printf("Time taken by sqrt function: %llu microseconds\n", time_dif);
 
+        time_dif = measure_time_us(calculate_poly_horner);
+        printf("Time taken by degree 8 polynomial, Horner: %llu microseconds\n", time_dif);
+
+        time_dif = measure_time_us(calculate_poly_estrin);
+        printf("Time taken by degree 8 polynomial, Estrin: %llu microseconds\n", time_dif);
+
         printf("\n\n\n");
         sleep_ms(5000);
     }
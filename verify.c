@@ -4,7 +4,9 @@
 #include <math.h>
 #include <locale.h>
 
+#ifndef FIXEDPT_BITS
 #define FIXEDPT_BITS 64
+#endif
 
 //#define FIXEDPT_WBITS 16
 
@@ -14,6 +16,7 @@
 /* This test program verifies the fixedpt precision, comparing it to
  * float and double precision results. */
 
+#if FIXEDPT_WBITS >= 3
 static const float pi_f = 3.14159265358979323846264338-0.1;
 static const double pi_d = 3.14159265358979323846264338-0.1;
 static const fixedpt pi_x = fixedpt_rconst(3.14159265358979323846264338-0.1);
@@ -21,7 +24,9 @@ static const fixedpt pi_x = fixedpt_rconst(3.14159265358979323846264338-0.1);
 static const float e_f = 2.71828182845904523536028747;
 static const double e_d = 2.71828182845904523536028747;
 static const fixedpt e_x = fixedpt_rconst(2.71828182845904523536028747);
+#endif
 
+#if FIXEDPT_WBITS >= 6
 static const float atan_1_f = 0.0;
 static const float atan_2_f = 0.5;
 static const float atan_3_f = 0.707106781;
@@ -35,16 +40,23 @@ static const double atan_4_d = 1.0;
 static const double atan_5_d = 0.866025403;
 
 static const fixedpt atan_1_x = fixedpt_rconst(0.0);
-static const fixedpt atan_2_x = fixedpt_rconst(0.5);
 static const fixedpt atan_3_x = fixedpt_rconst(0.707106781);
 static const fixedpt atan_4_x = fixedpt_rconst(1.0);
 static const fixedpt atan_5_x = fixedpt_rconst(0.866025403);
+#endif
+
+/* Also the gelu argument, which every format can hold */
+static const fixedpt atan_2_x = fixedpt_rconst(0.5);
+
+/* 2^FIXEDPT_FBITS, errors times this are in LSB; FIXEDPT_ONE overflows in Q1 */
+static const double lsb_d = (double)(1ULL << FIXEDPT_FBITS);
 
 /*=============================== Extra functions ===============================*/
 
 /*===============================================================================*/
 
 
+#if FIXEDPT_WBITS >= 6
 void
 verify_numbers()
 {
@@ -60,11 +72,26 @@ verify_numbers()
 	printf("pi as fixedpt converted to double: %0.6lf\n", fixedpt_todouble(pi_x));
 #endif
 
+	{
+		fixedpt pi_a;
+		double pi_b;
+
+		fixedpt_from_double_array(&pi_d, &pi_a, 1, FIXEDPT_ROUND_NEAREST);
+		fixedpt_to_double_array(&pi_a, &pi_b, 1);
+		printf("pi through fixedpt arrays:\t%0.15lf\n", pi_b);
+		printf("  delta fixedpt-double:\t%0.10lf\n", pi_b - pi_d);
+	}
+
 	printf("e as string:\t2.71828182845904523536028747\n");
 	printf("e as float:\t%0.6f\n", e_f);
 	printf("e as double:\t%0.15lf\n", e_d);
 	printf("e as fixedpt:\t%s\n", fixedpt_cstr(e_x, -2));
 	printf("  delta fixedpt-double:\t%0.10lf\n", atof(fixedpt_cstr(e_x, -2)) - e_d);
+
+	printf("pi*e-1 as double:\t%0.15lf\n", pi_d * e_d - 1);
+	printf("pi*e-1 as fixedpt_fma:\t%s\n", fixedpt_cstr(fixedpt_fma(pi_x, e_x, -FIXEDPT_ONE), -2));
+	printf("  delta fixedpt-double:\t%0.10lf\n",
+	    atof(fixedpt_cstr(fixedpt_fma(pi_x, e_x, -FIXEDPT_ONE), -2)) - (pi_d * e_d - 1));
 }
 
 void
@@ -133,6 +160,26 @@ verify_atan2()
 	printf("atan2(x) as double:\t%0.15lf\n", atan2(-atan_3_d, atan_5_d));
 	printf("atan2(x)) as fixedpt:\t%s\n", fixedpt_cstr(fixedpt_atan2(-atan_3_x, atan_5_x), -2));
 	printf("  delta fixedpt-double:\t%0.10lf\n", atof(fixedpt_cstr(fixedpt_atan2(-atan_3_x, atan_5_x), -2)) - atan2(-atan_3_d, atan_5_d));
+
+	{
+		/* 360 directions on the unit circle, as one batch */
+		fixedpt y[360], x[360], theta[360];
+		double d, dmax = 0;
+		int i;
+
+		for (i = 0; i < 360; i++) {
+			y[i] = fixedpt_rconst(sin((i - 180) * pi_d / 180));
+			x[i] = fixedpt_rconst(cos((i - 180) * pi_d / 180));
+		}
+		fixedpt_atan2_batch(y, x, theta, 360);
+		for (i = 0; i < 360; i++) {
+			d = fabs(fixedpt_todouble(theta[i]) -
+			    atan2(fixedpt_todouble(y[i]), fixedpt_todouble(x[i])));
+			if (d > dmax)
+				dmax = d;
+		}
+		printf("atan2 over 360 directions, max delta fixedpt-double:\t%0.10lf\n", dmax);
+	}
 }
 
 void
@@ -221,12 +268,579 @@ verify_powers()
 	printf("sqrt(3) as fixedpt:\t%s\n", fixedpt_cstr(fixedpt_sqrt(fixedpt_rconst(3)), -2));
 	printf("  delta fixedpt-double:\t%0.10lf\n", atof(fixedpt_cstr(fixedpt_sqrt(fixedpt_rconst(3)), -2)) - sqrt(3));
 
+#if FIXEDPT_WBITS >= 11
 	printf("sqrt(1000) as float:\t%0.6f\n", sqrtf(1000));
 	printf("sqrt(1000) as double:\t%0.15f\n", sqrt(1000));
 	printf("sqrt(1000) as fixedpt:\t%s\n", fixedpt_cstr(fixedpt_sqrt(fixedpt_rconst(1000)), -2));
 	printf("  delta fixedpt-double:\t%0.10lf\n", atof(fixedpt_cstr(fixedpt_sqrt(fixedpt_rconst(1000)), -2)) - sqrt(1000));
+#endif
+}
+#endif
+
+void
+verify_activations()
+{
+#if FIXEDPT_WBITS >= 3
+	printf("sigmoid(e) as float:\t%0.6f\n", 1.0f / (1.0f + expf(-e_f)));
+	printf("sigmoid(e) as double:\t%0.15lf\n", 1.0 / (1.0 + exp(-e_d)));
+	printf("sigmoid(e) as fixedpt:\t%s\n", fixedpt_cstr(fixedpt_sigmoid(e_x), -2));
+	printf("  delta fixedpt-double:\t%0.10lf\n", atof(fixedpt_cstr(fixedpt_sigmoid(e_x), -2)) - 1.0 / (1.0 + exp(-e_d)));
+
+	printf("tanh(-pi) as float:\t%0.6f\n", tanhf(-pi_f));
+	printf("tanh(-pi) as double:\t%0.15lf\n", tanh(-pi_d));
+	printf("tanh(-pi) as fixedpt:\t%s\n", fixedpt_cstr(fixedpt_tanh(-pi_x), -2));
+	printf("  delta fixedpt-double:\t%0.10lf\n", atof(fixedpt_cstr(fixedpt_tanh(-pi_x), -2)) - tanh(-pi_d));
+#endif
+
+	printf("gelu(0.5) as double:\t%0.15lf\n", 0.25 * (1.0 + tanh(sqrt(2.0 / 3.14159265358979323846) * (0.5 + 0.044715 * 0.125))));
+	printf("gelu(0.5) as fixedpt:\t%s\n", fixedpt_cstr(fixedpt_gelu(atan_2_x), -2));
+	printf("  delta fixedpt-double:\t%0.10lf\n", atof(fixedpt_cstr(fixedpt_gelu(atan_2_x), -2)) - 0.25 * (1.0 + tanh(sqrt(2.0 / 3.14159265358979323846) * (0.5 + 0.044715 * 0.125))));
+
+	/*
+	 * Sweep [-16, 16], or the whole range if that is smaller, plus both
+	 * ends. Small FIXEDPT_WBITS are the interesting case: there 2x and
+	 * the GELU gate argument do not fit in a fixedpt.
+	 */
+	{
+		fixedpt lo = (FIXEDPT_WBITS > 5) ? -fixedpt_fromint(16) : FIXEDPT_MIN;
+		fixedpt hi = (FIXEDPT_WBITS > 5) ? fixedpt_fromint(16) : FIXEDPT_MAX;
+		double es = 0, et = 0, eg = 0, e;
+		long double x;
+		fixedpt a;
+		int i;
+
+		for (i = -1; i <= 100001; i++) {
+			a = (i < 0) ? FIXEDPT_MIN : (i > 100000) ? FIXEDPT_MAX :
+			    (fixedpt)(lo + ((long double)hi - lo) * i / 100000);
+			x = (long double)fixedpt_todouble(a);
+			e = fabsl(fixedpt_todouble(fixedpt_sigmoid(a)) - 1 / (1 + expl(-x))) * lsb_d;
+			if (e > es)
+				es = e;
+			e = fabsl(fixedpt_todouble(fixedpt_tanh(a)) - tanhl(x)) * lsb_d;
+			if (e > et)
+				et = e;
+			if (x < -16 || x > 16)
+				continue;
+			e = fabsl(fixedpt_todouble(fixedpt_gelu(a)) -
+			    x / 2 * (1 + tanhl(sqrtl(2 / 3.14159265358979323846L) * (x + 0.044715L * x * x * x)))) * lsb_d;
+			if (e > eg)
+				eg = e;
+		}
+		printf("max error over [%0.1lf, %0.1lf]:\tsigmoid %0.2lf tanh %0.2lf gelu %0.2lf LSB\n",
+		    fixedpt_todouble(lo), fixedpt_todouble(hi), es, et, eg);
+	}
+}
+
+/*
+ * Convert values with a known result in every format, including -1, which
+ * is FIXEDPT_MIN in Q1, and two that saturate; a round trip alone would
+ * not notice a wrong scale.
+ */
+void
+verify_convert()
+{
+	static const float vf[6] = { 0.5f, -1.0f, -0.25f, 0.0f, 1e30f, -1e30f };
+	static const double vd[6] = { 0.5, -1.0, -0.25, 0.0, 1e30, -1e30 };
+	const fixedpt want[6] = { fixedpt_rconst(0.5), fixedpt_rconst(-1.0),
+	    fixedpt_rconst(-0.25), 0, FIXEDPT_MAX, FIXEDPT_MIN };
+	fixedpt of[6], od[6];
+	float bf[6];
+	double bd[6];
+	size_t sf, sd;
+	int i, bad = 0;
+
+	sf = fixedpt_from_float_array(vf, of, 6, FIXEDPT_ROUND_NEAREST);
+	sd = fixedpt_from_double_array(vd, od, 6, FIXEDPT_ROUND_NEAREST);
+	fixedpt_to_float_array(want, bf, 4);
+	fixedpt_to_double_array(want, bd, 4);
+	for (i = 0; i < 6; i++) {
+		bad += (of[i] != want[i]) + (od[i] != want[i]);
+		if (i < 4)
+			bad += (bf[i] != vf[i]) + (bd[i] != vd[i]);
+	}
+	printf("known conversions that differ:\t%d of 20, %d and %d saturated (2 expected)\n",
+	    bad, (int)sf, (int)sd);
+}
+
+/* Returns the error of the fixedpt v against x, saturated to the range, in LSB */
+static double
+err_sat(fixedpt v, long double x)
+{
+	x *= lsb_d;
+	if (x > FIXEDPT_MAX)
+		x = FIXEDPT_MAX;
+	if (x < FIXEDPT_MIN)
+		x = FIXEDPT_MIN;
+	return (fabsl((long double)v - x));
+}
+
+/*
+ * Sweep [-1, 1), which every format holds but for 1 itself in Q1, where
+ * the functions above are not run. Results beyond the range must saturate.
+ */
+void
+verify_unit()
+{
+	const fixedpt lo = (fixedpt)-((int64_t)1 << FIXEDPT_FBITS);
+	double es = 0, ee = 0, el = 0, ea = 0, eas = 0, eac = 0, e;
+	long double x;
+	fixedpt a;
+	int i;
+
+	for (i = 0; i < 65536; i++) {
+		a = (fixedpt)(lo + ldexpl(i, FIXEDPT_FBITS + 1) / 65536);
+		x = (long double)a / lsb_d;
+		if (a >= 0 && (e = err_sat(fixedpt_sqrt(a), sqrtl(x))) > es)
+			es = e;
+		if ((e = err_sat(fixedpt_exp(a), expl(x))) > ee)
+			ee = e;
+		if (a > 0 && (e = err_sat(fixedpt_ln(a), logl(x))) > el)
+			el = e;
+		if ((e = err_sat(fixedpt_atan(a), atanl(x))) > ea)
+			ea = e;
+		if ((e = err_sat(fixedpt_asin(a), asinl(x))) > eas)
+			eas = e;
+		if ((e = err_sat(fixedpt_acos(a), acosl(x))) > eac)
+			eac = e;
+	}
+	printf("max error over [-1, 1):	sqrt %0.2lf exp %0.2lf ln %0.2lf atan %0.2lf asin %0.2lf acos %0.2lf LSB\n",
+	    es, ee, el, ea, eas, eac);
 }
 
+/* The plain fixedpt sum it compares against reaches about 1922 */
+#if FIXEDPT_WBITS >= 12
+void
+verify_double_word()
+{
+	/* Reference: the exact products of the rounded fixedpt inputs */
+	double ref = 1000 * fixedpt_todouble(e_x) * fixedpt_todouble(atan_3_x);
+	fixedpt_dw acc = fixedpt_dw_from(0);
+	fixedpt sum = 0;
+	int i;
+
+	for (i = 0; i < 1000; i++) {
+		acc = fixedpt_dw_fma(acc, e_x, atan_3_x);
+		sum += fixedpt_mul(e_x, atan_3_x);
+	}
+	printf("sum of 1000 e*0.707 as double:\t%0.15lf\n", ref);
+	printf("sum of 1000 e*0.707 as fixedpt:\t%s\n", fixedpt_cstr(sum, -2));
+	printf("  delta fixedpt-double:\t%0.10lf\n", atof(fixedpt_cstr(sum, -2)) - ref);
+	printf("sum of 1000 e*0.707 as fixedpt_dw:\t%0.15lf\n", fixedpt_dw_todouble(acc));
+	printf("  delta fixedpt_dw-double:\t%0.10lf\n", fixedpt_dw_todouble(acc) - ref);
+}
+#endif
+
+void
+verify_packed()
+{
+	fixedpt data[100], back[100];
+	uint64_t packed[200];
+	double d, dmax = 0;
+	int i, mode, nsat;
+	/* A sign, one whole bit and a spare above the fraction bits of sin */
+	int width = (FIXEDPT_FBITS + 3 < FIXEDPT_BITS) ? FIXEDPT_FBITS + 3 : FIXEDPT_BITS;
+
+	for (i = 0; i < 100; i++)
+#if FIXEDPT_WBITS >= 8
+		data[i] = fixedpt_sin(fixedpt_fromint(i));
+#else
+		data[i] = fixedpt_rconst(sin(i) / 2);	/* i itself is out of range */
+#endif
+	for (mode = FIXEDPT_PACK_PLAIN; mode <= FIXEDPT_PACK_EXPONENT; mode++) {
+		nsat = (int)fixedpt_pack(data, 100, width, mode, packed);
+		fixedpt_unpack(packed, 0, 100, width, mode, back);
+		for (i = 0, dmax = 0; i < 100; i++) {
+			d = fabs(fixedpt_todouble(back[i]) - fixedpt_todouble(data[i]));
+			if (d > dmax)
+				dmax = d;
+		}
+		printf("sin(0..99) packed in %d bits, mode %d (%d bytes):\t%d saturated, max delta %0.10lf\n",
+		    width, mode, (int)fixedpt_pack_size(100, width, mode), nsat, dmax);
+	}
+
+	/* Invalid widths and modes are refused without touching the buffers */
+	{
+		static const int bad[3][2] = { { 0, FIXEDPT_PACK_PLAIN },
+		    { FIXEDPT_BITS + 1, FIXEDPT_PACK_OFFSET }, { 8, FIXEDPT_PACK_EXPONENT + 1 } };
+		int j, written = 0;
+
+		for (j = 0; j < 3; j++) {
+			for (i = 0; i < 100; i++) {
+				packed[i] = 0x5a5a5a5a5a5a5a5aULL;
+				back[i] = 77;
+			}
+			written += (int)fixedpt_pack(data, 100, bad[j][0], bad[j][1], packed);
+			written += (fixedpt_unpack_at(packed, 3, bad[j][0], bad[j][1]) != 0);
+			fixedpt_unpack(packed, 0, 100, bad[j][0], bad[j][1], back);
+			for (i = 0; i < 100; i++)
+				written += (packed[i] != 0x5a5a5a5a5a5a5a5aULL) + (back[i] != 77);
+		}
+		printf("invalid width or mode, results and writes:\t%d\n", written);
+	}
+}
+
+void
+verify_stats()
+{
+	fixedpt data[1000], min, max;
+	fixedpt_stats win;
+	size_t counts[4] = { 0, 0, 0, 0 };
+	double m = 0, v = 0, ms = 0;
+	int i;
+#if FIXEDPT_WBITS >= 6
+	const char *what = "10 sin(0..999) + 20";
+	const double lo = 10, hi = 30;
+
+	for (i = 0; i < 1000; i++)
+		data[i] = fixedpt_add(fixedpt_mul(fixedpt_rconst(10), fixedpt_sin(fixedpt_fromint(i))),
+		    fixedpt_rconst(20));
+#else
+	const char *what = "1000 uniform [0, 1)";
+	const double lo = 0.25, hi = 0.75;
+	fixedpt_rng rng;
+
+	fixedpt_rng_init(&rng, 1, 0);
+	fixedpt_rng_uniform_fill(&rng, data, 1000);
+#endif
+	for (i = 0; i < 1000; i++) {
+		m += fixedpt_todouble(data[i]) / 1000;
+		ms += fixedpt_todouble(data[i]) * fixedpt_todouble(data[i]) / 1000;
+	}
+	for (i = 0; i < 1000; i++)
+		v += (fixedpt_todouble(data[i]) - m) * (fixedpt_todouble(data[i]) - m) / 1000;
+	printf("mean of %s:\t%0.10lf\t%0.10lf\n", what, fixedpt_todouble(fixedpt_mean(data, 1000)), m);
+	printf("variance:\t\t\t%0.10lf\t%0.10lf\n", fixedpt_todouble(fixedpt_var(data, 1000)), v);
+	printf("rms:\t\t\t\t%0.10lf\t%0.10lf\n", fixedpt_todouble(fixedpt_rms(data, 1000)), sqrt(ms));
+	fixedpt_minmax(data, 1000, &min, &max);
+	printf("min, max:\t\t\t%0.10lf\t%0.10lf\n", fixedpt_todouble(min), fixedpt_todouble(max));
+	i = (int)fixedpt_histogram(data, 1000, fixedpt_rconst(lo), fixedpt_rconst(hi), counts, 4);
+	printf("histogram over [%g, %g):\t%d %d %d %d, %d outside\n", lo, hi,
+	    (int)counts[0], (int)counts[1], (int)counts[2], (int)counts[3], i);
+
+	/* A window of the last 100 slid over the data matches a fresh one */
+	fixedpt_stats_init(&win);
+	fixedpt_stats_add(&win, data, 100);
+	for (i = 100; i < 1000; i++)
+		fixedpt_stats_slide(&win, data[i], data[i - 100]);
+	printf("variance of the last 100:\t%0.10lf\t%0.10lf\n",
+	    fixedpt_todouble(fixedpt_stats_var(&win)), fixedpt_todouble(fixedpt_var(data + 900, 100)));
+}
+
+#if FIXEDPT_WBITS >= 6
+void
+verify_lut()
+{
+	fixedpt sq[17], xe[6], ye[6], z[9], in[4], out[4];
+	fixedpt_lut_seg slope[5];
+	fixedpt_lut_axis a, b;
+	fixedpt_lut lut;
+	fixedpt_lut2 lut2;
+	int i;
+
+	/* sqrt sampled every 1.0 over [0, 16] */
+	for (i = 0; i <= 16; i++)
+		sq[i] = fixedpt_sqrt(fixedpt_fromint(i));
+	fixedpt_lut_axis_uniform(&a, 0, FIXEDPT_FBITS, 17);
+	fixedpt_lut_init(&lut, &a, sq, NULL);
+	printf("uniform lut sqrt(10.25):\t%0.10lf\t%0.10lf\n",
+	    fixedpt_todouble(fixedpt_lut_eval(&lut, fixedpt_rconst(10.25))), (sqrt(10) * 0.75 + sqrt(11) * 0.25));
+
+	/* exp at breakpoints closer together where it is steeper */
+	xe[0] = fixedpt_rconst(-2); xe[1] = fixedpt_rconst(0); xe[2] = fixedpt_rconst(1);
+	xe[3] = fixedpt_rconst(1.5); xe[4] = fixedpt_rconst(1.75); xe[5] = fixedpt_rconst(2);
+	for (i = 0; i < 6; i++)
+		ye[i] = fixedpt_exp(xe[i]);
+	fixedpt_lut_axis_points(&a, xe, 6);
+	fixedpt_lut_init(&lut, &a, ye, slope);
+	in[0] = fixedpt_rconst(-3); in[1] = fixedpt_rconst(0.5); in[2] = fixedpt_rconst(1.6); in[3] = fixedpt_rconst(1.75);
+	fixedpt_lut_eval_batch(&lut, in, out, 4);
+	printf("non-uniform lut exp(-3, 0.5, 1.6, 1.75):\t%0.6lf %0.6lf %0.6lf %0.6lf\n",
+	    fixedpt_todouble(out[0]), fixedpt_todouble(out[1]), fixedpt_todouble(out[2]), fixedpt_todouble(out[3]));
+
+	/* x * y on a 3x3 grid over [0, 2]^2 is bilinear, so exact */
+	for (i = 0; i < 9; i++)
+		z[i] = fixedpt_fromint((i % 3) * (i / 3));
+	fixedpt_lut_axis_uniform(&a, 0, FIXEDPT_FBITS, 3);
+	fixedpt_lut_axis_uniform(&b, 0, FIXEDPT_FBITS, 3);
+	fixedpt_lut2_init(&lut2, &a, &b, z, NULL, NULL);
+	printf("2D lut x * y at (1.5, 0.25):\t%0.10lf\t%0.10lf\n",
+	    fixedpt_todouble(fixedpt_lut2_eval(&lut2, fixedpt_rconst(1.5), fixedpt_rconst(0.25))), 1.5 * 0.25);
+}
+
+void
+verify_complex()
+{
+	fixedpt_complex a, b, r, v[3];
+	fixedpt m[3];
+
+	a.re = fixedpt_rconst(1.5); a.im = fixedpt_rconst(-2);
+	b.re = fixedpt_rconst(0.25); b.im = fixedpt_rconst(3);
+	r = fixedpt_cmul(a, b);
+	printf("(1.5 - 2i) * (0.25 + 3i):\t%0.10lf %+0.10lfi\t%0.10lf %+0.10lfi\n",
+	    fixedpt_todouble(r.re), fixedpt_todouble(r.im), 1.5 * 0.25 + 2 * 3, 1.5 * 3 - 2 * 0.25);
+	r = fixedpt_cmul(a, fixedpt_conj(a));
+	printf("|1.5 - 2i|^2 and |1.5 - 2i|:\t%0.10lf %0.10lf\t%0.10lf %0.10lf\n",
+	    fixedpt_todouble(fixedpt_cabs2(a)), fixedpt_todouble(fixedpt_cabs(a)), fixedpt_todouble(r.re), 2.5);
+	printf("arg(1.5 - 2i):\t\t\t%0.10lf\t%0.10lf\n", fixedpt_todouble(fixedpt_carg(a)), atan2(-2, 1.5));
+	r = fixedpt_cexp(a);
+	printf("exp(1.5 - 2i):\t\t\t%0.10lf %+0.10lfi\t%0.10lf %+0.10lfi\n",
+	    fixedpt_todouble(r.re), fixedpt_todouble(r.im), exp(1.5) * cos(-2), exp(1.5) * sin(-2));
+
+	/* The 3-4-5, 5-12-13 and 8-15-17 triangles */
+	v[0].re = fixedpt_rconst(3); v[0].im = fixedpt_rconst(-4);
+	v[1].re = fixedpt_rconst(-5); v[1].im = fixedpt_rconst(12);
+	v[2].re = fixedpt_rconst(-8); v[2].im = fixedpt_rconst(-15);
+	fixedpt_cabs_batch(v, m, 3);
+	printf("|3 - 4i|, |-5 + 12i|, |-8 - 15i|:\t%0.10lf %0.10lf %0.10lf\n",
+	    fixedpt_todouble(m[0]), fixedpt_todouble(m[1]), fixedpt_todouble(m[2]));
+}
+#endif
+
+void
+verify_rng()
+{
+	static fixedpt data[10000];
+	fixedpt_rng rng;
+	double m = 0;
+#if FIXEDPT_WBITS >= 6
+	double v = 0;
+#endif
+	int i;
+
+	fixedpt_rng_init(&rng, 1, 0);
+	fixedpt_rng_uniform_fill(&rng, data, 10000);
+	for (i = 0; i < 10000; i++)
+		m += fixedpt_todouble(data[i]) / 10000;
+	printf("mean of 10000 uniform [0, 1):\t%0.10lf\t%0.10lf\n", m, 0.5);
+	fixedpt_rng_triangular_fill(&rng, fixedpt_rconst(0.5), data, 10000);
+	for (i = 0, m = 0; i < 10000; i++)
+		m += fixedpt_todouble(data[i]) * fixedpt_todouble(data[i]) / 10000;
+	printf("variance of triangular (-0.5, 0.5):\t%0.10lf\t%0.10lf\n", m, 0.25 / 6);
+#if FIXEDPT_WBITS >= 6
+	fixedpt_rng_normal_fill(&rng, data, 10000);
+	for (i = 0, m = 0; i < 10000; i++)
+		m += fixedpt_todouble(data[i]) / 10000;
+	for (i = 0; i < 10000; i++)
+		v += (fixedpt_todouble(data[i]) - m) * (fixedpt_todouble(data[i]) - m) / 10000;
+	printf("mean, variance of normal:\t%0.10lf %0.10lf\t%0.10lf %0.10lf\n", m, v, 0.0, 1.0);
+#endif
+}
+
+#if FIXEDPT_WBITS >= 6
+void
+verify_nco()
+{
+	static fixedpt s[1000000];
+	fixedpt_nco nco;
+	fixedpt f = fixedpt_rconst(0.7), a = fixedpt_rconst(0.5), d = a;
+	long double x;
+	double en = 0, ed = 0, e;
+	int i;
+
+	/* The naive oscillator adds f to a fixedpt angle, minus 2 pi on wrapping */
+	fixedpt_nco_init(&nco, f, a);
+	fixedpt_nco_fill(&nco, s, NULL, 1000000);
+	for (i = 0; i < 1000000; i++) {
+		x = (long double)fixedpt_todouble(a) + (long double)i * fixedpt_todouble(f);
+		e = fabsl(fixedpt_todouble(s[i]) - sinl(x)) * lsb_d;
+		if (e > en)
+			en = e;
+		e = fabsl(fixedpt_todouble(fixedpt_sin(d)) - sinl(x)) * lsb_d;
+		if (e > ed)
+			ed = e;
+		d += f;
+		if (d > FIXEDPT_PI)
+			d -= FIXEDPT_TWO_PI;
+	}
+	printf("max error of 1000000 nco samples:\t%0.2lf ulp\n", en);
+	printf("max error of fixedpt_sin of a running angle:\t%0.2lf ulp\n", ed);
+}
+#endif
+
+/* Runs the dispatched batch kernels on n elements, 16 * n outputs */
+void
+verify_dispatch_run(const fixedpt *x, const fixedpt *y, const float *f, const double *d,
+    fixedpt *o, size_t n, fixedpt_acc *sum)
+{
+	fixedpt_stats st;
+	fixedpt_rng rng;
+	fixedpt_nco nco;
+
+	fixedpt_mul_batch(x, y, o, n);
+	fixedpt_scale_batch(x, y[0], o + n, n);
+	fixedpt_sigmoid_batch(x, o + 2 * n, n);
+	fixedpt_tanh_batch(x, o + 3 * n, n);
+	fixedpt_gelu_batch(x, o + 4 * n, n);
+	fixedpt_softmax(x, o + 5 * n, n);
+	fixedpt_cmul_split_batch(x, y, y, x, o + 6 * n, o + 7 * n, n);
+	fixedpt_cabs_split_batch(x, y, o + 8 * n, n);
+	fixedpt_from_float_array(f, o + 9 * n, n, FIXEDPT_ROUND_NEAREST);
+	fixedpt_from_float_array(f, o + 10 * n, n, FIXEDPT_ROUND_TRUNCATE);
+	fixedpt_from_double_array(d, o + 11 * n, n, FIXEDPT_ROUND_NEAREST);
+	fixedpt_rng_init(&rng, 1, 0);
+	fixedpt_rng_uniform_fill(&rng, o + 12 * n, n);
+	fixedpt_nco_init(&nco, fixedpt_rconst(0.7), fixedpt_rconst(0.5));
+	fixedpt_nco_fill(&nco, o + 13 * n, o + 14 * n, n);
+	fixedpt_stats_init(&st);
+	fixedpt_stats_add(&st, x, n);
+	o[15 * n] = fixedpt_stats_mean(&st);
+	o[15 * n + 1] = fixedpt_stats_var(&st);
+	*sum = fixedpt_sum(x, n);
+}
+
+void
+verify_dispatch()
+{
+	static const char *name[3] = { "scalar", "AVX2", "AVX-512" };
+	static fixedpt x[1003], y[1003], o[3][16 * 1003];
+	static float f[1003];
+	static double d[1003];
+	fixedpt_acc sum[3];
+	uint64_t h = 1;
+	int isa, i, diff;
+
+	/* Inputs over the whole range, with conversions out of it and NaN */
+	for (i = 0; i < 1003; i++) {
+		h ^= h << 13; h ^= h >> 7; h ^= h << 17;
+		x[i] = (fixedpt)h;
+		y[i] = (fixedpt)(h >> 32);
+		f[i] = fixedpt_tofloat(x[i]) * 1.25f;
+		d[i] = fixedpt_todouble(y[i]) * 1.25;
+	}
+	f[0] = NAN; f[1] = INFINITY; f[2] = -INFINITY; d[0] = NAN;
+	for (isa = FIXEDPT_ISA_SCALAR; isa <= FIXEDPT_ISA_AVX512; isa++) {
+		if (fixedpt_dispatch_force(isa) < 0) {
+			printf("%s path:\t\t\tnot available\n", name[isa]);
+			continue;
+		}
+		verify_dispatch_run(x, y, f, d, o[isa], 1003, &sum[isa]);
+		for (i = 0, diff = (sum[isa] != sum[0]); i < 16 * 1003; i++)
+			diff += (o[isa][i] != o[0][i]);
+		printf("%s path outputs that differ from scalar:\t%d of %d\n", name[isa], diff, 16 * 1003 + 1);
+		/* In Q1.15 the wide paths multiply with pmulhrsw */
+		for (i = 0, diff = 0; i < 1003; i++)
+			diff += (o[isa][i] != fixedpt_mul(x[i], y[i]));
+		printf("%s path products that differ from fixedpt_mul:\t%d of %d\n", name[isa], diff, 1003);
+	}
+	fixedpt_dispatch_init();
+}
+
+/*
+ * Five chunks and a partial one, so that an -fopenmp build splits the work
+ * across threads; the output is the same with and without it.
+ */
+void
+verify_parallel()
+{
+	enum { N = 5 * FIXEDPT_PARALLEL_CHUNK + 7 };
+	static fixedpt in[N], out[N], ref[N];
+	fixedpt_rng rng;
+	fixedpt_acc sum = 0;
+	fixedpt min = FIXEDPT_MAX, max = FIXEDPT_MIN;
+	int i, diff;
+
+	/* Raw bits over the whole range, so the sum overflows a fixedpt */
+	fixedpt_rng_init(&rng, 3, 0);
+	for (i = 0; i < N; i++) {
+		in[i] = (fixedpt)fixedpt_rng_bits(&rng);
+		sum += in[i];
+		min = (in[i] < min) ? in[i] : min;
+		max = (in[i] > max) ? in[i] : max;
+	}
+	diff = (fixedpt_parallel_sum(in, N) != sum) + (fixedpt_sum(in, N) != sum) +
+	    (fixedpt_parallel_min(in, N) != min) + (fixedpt_parallel_max(in, N) != max);
+	printf("parallel sum, min, max that differ from serial:\t%d of 4\n", diff);
+
+	fixedpt_parallel_map(fixedpt_sigmoid, in, out, N);
+	for (i = 0, diff = 0; i < N; i++)
+		diff += (out[i] != fixedpt_sigmoid(in[i]));
+	fixedpt_parallel_map_batch(fixedpt_tanh_batch, in, out, N);
+	fixedpt_tanh_batch(in, ref, N);
+	for (i = 0; i < N; i++)
+		diff += (out[i] != ref[i]);
+	printf("parallel map outputs that differ from serial:\t%d of %d\n", diff, 2 * N);
+}
+
+#if defined(FIXEDPT_ERROR_COUNTERS) && FIXEDPT_WBITS >= 6
+void
+verify_errors()
+{
+	uint64_t before[FIXEDPT_FN_COUNT][FIXEDPT_ERR_COUNT];
+	uint64_t after[FIXEDPT_FN_COUNT][FIXEDPT_ERR_COUNT];
+	fixedpt_complex z = { FIXEDPT_MAX, FIXEDPT_MAX };
+	volatile fixedpt r;
+	int fn, cls;
+
+	fixedpt_errors_snapshot(before);
+	r = fixedpt_sqrt(-FIXEDPT_ONE);
+	r = fixedpt_ln(0);
+	r = fixedpt_asin(FIXEDPT_TWO);
+	r = fixedpt_div(FIXEDPT_MAX, FIXEDPT_ONE >> 1);
+	r = fixedpt_mul(FIXEDPT_MAX, FIXEDPT_TWO);
+	r = fixedpt_exp(FIXEDPT_MAX);
+	r = fixedpt_cabs(z);
+	(void)r;
+	fixedpt_errors_snapshot(after);
+	for (fn = 0; fn < FIXEDPT_FN_COUNT; fn++)
+		for (cls = 0; cls < FIXEDPT_ERR_COUNT; cls++)
+			if (after[fn][cls] != before[fn][cls])
+				printf("errors counted in %s:\t%s %d\n", fixedpt_errors_fn_name(fn),
+				    fixedpt_errors_class_name(cls), (int)(after[fn][cls] - before[fn][cls]));
+}
+#endif
+
+#ifdef FIXEDPT_TRACE
+void
+verify_trace()
+{
+	fixedpt_trace_stats before, after;
+	volatile fixedpt r;
+	int i;
+
+	fixedpt_trace_snapshot(FIXEDPT_TRACE_SQRT, &before);
+	for (i = 0; i < 10000; i++)
+		r = fixedpt_sqrt(fixedpt_fromint(i));
+	(void)r;
+	fixedpt_trace_snapshot(FIXEDPT_TRACE_SQRT, &after);
+	printf("traced calls of sqrt:\t%d, %d timed, p50 %d p99 %d cycles\n",
+	    (int)(after.calls - before.calls), (int)(after.sampled - before.sampled),
+	    (int)after.p50, (int)after.p99);
+	for (i = 0; i <= FIXEDPT_BITS; i++)
+		if (after.mag[i] != before.mag[i])
+			printf("  |x| < 2^%d:\t%d timed, mean %d cycles\n", i - FIXEDPT_FBITS,
+			    (int)(after.mag[i] - before.mag[i]),
+			    (int)((after.mag_cycles[i] - before.mag_cycles[i]) / (after.mag[i] - before.mag[i])));
+}
+#endif
+
+#ifdef FIXEDPT_HAVE_FILE
+void
+verify_file()
+{
+	const char *path = "verify.fxp";
+	fixedpt_file_view view;
+	fixedpt_rng rng;
+	fixedpt data[16];
+	int i, same = 1;
+
+	/* Raw bits, which every format can hold */
+	fixedpt_rng_init(&rng, 2, 0);
+	for (i = 0; i < 16; i++)
+		data[i] = (fixedpt)fixedpt_rng_bits(&rng);
+	if (fixedpt_file_write(path, data, 16) != 0 ||
+	    fixedpt_file_map(path, &view, 0) != 0) {
+		printf("binary file round trip:\tfailed\n");
+		return;
+	}
+	for (i = 0; i < 16; i++)
+		same &= (view.data[i] == data[i]);
+	printf("binary file round trip:\t%d elements, %s, %s\n", (int)view.count,
+	    same ? "identical" : "DIFFERENT", view.map != NULL ? "mapped in place" : "copied");
+	fixedpt_file_unmap(&view);
+	remove(path);
+}
+#endif
+
 int
 main() 
 {
@@ -234,6 +848,8 @@ main()
 	printf("fixedptc library version: %s\n", FIXEDPT_VCSID);
 	printf("Using %d-bit precision, %d.%d format\n\n", FIXEDPT_BITS, FIXEDPT_WBITS, FIXEDPT_FBITS);
 
+	/* These take pi, e and constants up to 50, which need 6 whole bits */
+#if FIXEDPT_WBITS >= 6
 	verify_numbers();
 	printf("\n");
 	verify_atan2();
@@ -246,6 +862,49 @@ main()
 	printf("\n");
 	verify_powers();
 	printf("\n");
+#endif
+	verify_activations();
+	printf("\n");
+	verify_unit();
+	printf("\n");
+	verify_convert();
+	printf("\n");
+#if FIXEDPT_WBITS >= 12
+	verify_double_word();
+	printf("\n");
+#endif
+	verify_packed();
+	printf("\n");
+	verify_stats();
+	printf("\n");
+#if FIXEDPT_WBITS >= 6
+	verify_lut();
+	printf("\n");
+	verify_complex();
+	printf("\n");
+#endif
+	verify_rng();
+	printf("\n");
+#if FIXEDPT_WBITS >= 6
+	verify_nco();
+	printf("\n");
+#endif
+	verify_dispatch();
+	printf("\n");
+	verify_parallel();
+#if defined(FIXEDPT_ERROR_COUNTERS) && FIXEDPT_WBITS >= 6
+	printf("\n");
+	verify_errors();
+#endif
+#ifdef FIXEDPT_TRACE
+	printf("\n");
+	verify_trace();
+#endif
+#ifdef FIXEDPT_HAVE_FILE
+	printf("\n");
+	verify_file();
+#endif
+	printf("\n");
 
 	return (0);
 }